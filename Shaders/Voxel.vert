@@ -1,11 +1,9 @@
 #version 450 core
 
 
-layout (location = 0) in vec3 position;
-layout (location = 1) in vec3 normals;
-layout (location = 2) in vec2 texCoord;
-layout (location = 3) in vec4 color;
-layout (location = 4) in uvec2 texOffset;
+/* Packed VoxelVertex: x, y, z and side in the first word, u, v and atlas offset in the second one */
+layout (location = 0) in uint packedPosition;
+layout (location = 2) in uint packedTexture;
 
 layout(location = 6) out VsOut {
 	vec4 color;
@@ -18,18 +16,37 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+/* Size of the voxel and center of the voxel array, positions are packed as corners of the voxel grid */
+uniform float voxelSize;
+uniform vec3 voxelCenter;
+
 out gl_PerVertex
 {
   vec4 gl_Position;
 };
 
+/* Normals for Voxel::Side: NORTH, SOUTH, EAST, WEST, TOP, BOTTOM */
+const vec3 sideNormals[6] = vec3[6](
+	vec3(0.0, 0.0, -1.0),
+	vec3(0.0, 0.0, 1.0),
+	vec3(1.0, 0.0, 0.0),
+	vec3(-1.0, 0.0, 0.0),
+	vec3(0.0, 1.0, 0.0),
+	vec3(0.0, -1.0, 0.0)
+);
+
 void main()
 {
+   uvec3 gridPosition = uvec3(packedPosition, packedPosition >> 8, packedPosition >> 16) & 0xffu;
+   uint side = (packedPosition >> 24) & 0x7u;
+   vec3 position = vec3(gridPosition) * voxelSize - voxelCenter;
+
    gl_Position = projection * view * model * vec4(position, 1.0);
 
-   vsOut.color = color;
-   vsOut.texCoord = texCoord;
-   vsOut.texOffset = texOffset;
+   /* Color is not stored, voxels drawn without the atlas are white and shaded only by the light */
+   vsOut.color = vec4(1.0);
+   vsOut.texCoord = vec2(packedTexture & 0xffu, (packedTexture >> 8) & 0xffu);
+   vsOut.texOffset = vec2((packedTexture >> 16) & 0xffu, packedTexture >> 24);
 
-   vsOut.normal = mat3(transpose(inverse(model))) * normals;  
+   vsOut.normal = mat3(transpose(inverse(model))) * sideNormals[side];  
 }
@@ -0,0 +1,193 @@
+#include "AllocationCounter.h"
+
+#ifdef VE_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+namespace vengine {
+
+static thread_local bool counting = false;
+static thread_local uint64_t allocations = 0;
+
+void
+AllocationCounter::Start()
+{
+	allocations = 0;
+	counting = true;
+}
+
+uint64_t
+AllocationCounter::Stop()
+{
+	counting = false;
+	return allocations;
+}
+
+/* Count allocation and allocate memory, returns nullptr if there is not enough memory */
+static void* allocate(size_t size)
+{
+	if (counting)
+		++allocations;
+
+	return malloc(size > 0 ? size : 1);
+}
+
+#ifdef __cpp_aligned_new
+
+static void* allocateAligned(size_t size, std::align_val_t alignment)
+{
+	if (counting)
+		++allocations;
+
+#ifdef _MSC_VER
+	return _aligned_malloc(size > 0 ? size : 1, (size_t)alignment);
+#else
+	/* Size must be multiple of the alignment */
+	size_t align = (size_t)alignment;
+	size_t rounded = (size + align - 1) / align * align;
+	return aligned_alloc(align, rounded > 0 ? rounded : align);
+#endif
+}
+
+static void freeAligned(void* memory)
+{
+#ifdef _MSC_VER
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+}
+
+#endif
+
+}
+
+void* operator new(size_t size)
+{
+	void* memory = vengine::allocate(size);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return vengine::allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return vengine::allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
+
+#ifdef __cpp_aligned_new
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* memory = vengine::allocateAligned(size, alignment);
+	if (memory == nullptr)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return vengine::allocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return vengine::allocateAligned(size, alignment);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	vengine::freeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+	vengine::freeAligned(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+	vengine::freeAligned(memory);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+	vengine::freeAligned(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	vengine::freeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	vengine::freeAligned(memory);
+}
+
+#endif
+
+#else
+
+namespace vengine {
+
+void
+AllocationCounter::Start()
+{
+}
+
+uint64_t
+AllocationCounter::Stop()
+{
+	return 0;
+}
+
+}
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace vengine {
+
+/*
+* Counts heap allocations made by the calling thread between Start and Stop. Global operator new is replaced
+* in AllocationCounter.cpp, which adds a check to every allocation of the program, so it is compiled only when
+* VE_COUNT_ALLOCATIONS is defined in the preprocessor definitions of the benchmark build. Otherwise nothing is counted.
+*/
+class AllocationCounter {
+public:
+	/* Check if allocations are counted in this build */
+	static bool IsEnabled();
+	/* Start counting allocations of this thread */
+	static void Start();
+	/* Stop counting and return number of allocations since Start */
+	static uint64_t Stop();
+};
+
+inline bool
+AllocationCounter::IsEnabled()
+{
+#ifdef VE_COUNT_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+}
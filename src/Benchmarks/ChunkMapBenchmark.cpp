@@ -0,0 +1,142 @@
+#include "ChunkMapBenchmark.h"
+
+#include "Errors.h"
+#include "Engine/ChunkMap.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+
+namespace vengine {
+
+struct KeyHash {
+	size_t operator()(const ChunkMap::Key& key) const
+	{
+		return std::hash<int>()(key.x) ^ (std::hash<int>()(key.y) << 10) ^ (std::hash<int>()(key.z) << 20);
+	}
+};
+
+typedef std::unordered_map<ChunkMap::Key, Octree*, KeyHash> ReferenceMap;
+
+/* Map never dereferences the nodes, so distinct fake pointers are enough to tell them apart */
+static Octree* makeNode(int i)
+{
+	return (Octree*)(uintptr_t)(8 * (i + 1));
+}
+
+/* Compare the map with the reference after random operations on keys of a small area, so most of them hit existing keys */
+static bool compareMaps(std::ostream& log)
+{
+	const int operations = 1000000;
+	std::mt19937 random(312538u);
+	ChunkMap map;
+	ReferenceMap reference;
+
+	for (int i = 0; i < operations; ++i) {
+		ChunkMap::Key key = { (int)(random() % 48) - 24, (int)(random() % 12) - 6, (int)(random() % 48) - 24 };
+		unsigned int operation = random() % 3;
+
+		if (operation == 0) {
+			map.Insert(key, makeNode(i));
+			reference[key] = makeNode(i);
+		}
+		else if (operation == 1) {
+			if (map.Remove(key) != (reference.erase(key) != 0)) {
+				log << "Chunk map removed (" << key.x << ", " << key.y << ", " << key.z << ") differently at operation " << i << "\n";
+				return false;
+			}
+		}
+		else {
+			ReferenceMap::iterator it = reference.find(key);
+			if (map.Find(key) != (it != reference.end() ? it->second : nullptr)) {
+				log << "Chunk map found (" << key.x << ", " << key.y << ", " << key.z << ") differently at operation " << i << "\n";
+				return false;
+			}
+		}
+
+		if (map.GetSize() != reference.size()) {
+			log << "Chunk map has " << map.GetSize() << " nodes instead of " << reference.size() << " at operation " << i << "\n";
+			return false;
+		}
+	}
+
+	for (ReferenceMap::iterator it = reference.begin(); it != reference.end(); ++it) {
+		if (map.Find(it->first) != it->second) {
+			log << "Chunk map lost (" << it->first.x << ", " << it->first.y << ", " << it->first.z << ")\n";
+			return false;
+		}
+	}
+
+	map.Clear();
+	if (map.GetSize() != 0 || map.Find(reference.begin()->first) != nullptr) {
+		log << "Chunk map is not empty after clearing\n";
+		return false;
+	}
+
+	return true;
+}
+
+int runChunkMapBenchmark(bool csv)
+{
+	std::ostream& log = csv ? std::cerr : std::cout;
+
+	/* Chunks resident around the player, lookups go one chunk further to include missing ones like the neighbours do */
+	const int radius = 20;
+	const int verticalRadius = 4;
+	const int repeats = 200;
+
+	if (csv)
+		std::cout << "method,nsPerLookup\n";
+	else
+		std::cout << "Chunk map benchmark, " << 2 * radius + 1 << "x" << 2 * verticalRadius + 1 << "x" << 2 * radius + 1 << " chunks\n";
+
+	bool same = compareMaps(log);
+
+	ChunkMap map;
+	ReferenceMap reference;
+	for (int z = -radius; z <= radius; ++z) {
+		for (int y = -verticalRadius; y <= verticalRadius; ++y) {
+			for (int x = -radius; x <= radius; ++x) {
+				ChunkMap::Key key = { x, y, z };
+				map.Insert(key, makeNode(0));
+				reference[key] = makeNode(0);
+			}
+		}
+	}
+
+	size_t found = 0;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < repeats; ++r)
+		for (int z = -radius - 1; z <= radius + 1; ++z)
+			for (int y = -verticalRadius - 1; y <= verticalRadius + 1; ++y)
+				for (int x = -radius - 1; x <= radius + 1; ++x)
+					found += map.Find({ x, y, z }) != nullptr ? 1 : 0;
+	std::chrono::duration<double> mapTime = std::chrono::high_resolution_clock::now() - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < repeats; ++r)
+		for (int z = -radius - 1; z <= radius + 1; ++z)
+			for (int y = -verticalRadius - 1; y <= verticalRadius + 1; ++y)
+				for (int x = -radius - 1; x <= radius + 1; ++x)
+					found += reference.find({ x, y, z }) != reference.end() ? 1 : 0;
+	std::chrono::duration<double> referenceTime = std::chrono::high_resolution_clock::now() - start;
+
+	double lookups = (double)repeats * (2 * radius + 3) * (2 * verticalRadius + 3) * (2 * radius + 3);
+	if (csv) {
+		std::cout << "ChunkMap," << 1e9 * mapTime.count() / lookups << "\n";
+		std::cout << "unordered_map," << 1e9 * referenceTime.count() / lookups << "\n";
+	}
+	else {
+		std::cout << "  ChunkMap: " << 1e9 * mapTime.count() / lookups << " ns per lookup\n";
+		std::cout << "  unordered_map: " << 1e9 * referenceTime.count() / lookups << " ns per lookup\n";
+	}
+
+	/* Count is printed, so the loops cannot be removed by the compiler */
+	log << "Chunk map " << (same ? "OK" : "FAILED") << " (found " << found << ")\n";
+	return same ? 0 : VE_FAULT;
+}
+
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace vengine {
+
+/*
+* Apply random insertions, removals and lookups to the chunk map and to std::unordered_map at the same time,
+* both must find the same nodes and hold the same number of them after every operation. Lookups of chunks
+* around the player are measured for both.
+*/
+int runChunkMapBenchmark(bool csv = false);
+
+}
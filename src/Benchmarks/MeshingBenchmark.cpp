@@ -0,0 +1,512 @@
+#include "MeshingBenchmark.h"
+#include "AllocationCounter.h"
+
+#include "Errors.h"
+#include "Engine/TerrainGenerator.h"
+#include "Engine/MeshWorkers.h"
+#include "Engine/MeshCache.h"
+#include "Engine/VoxelVertex.h"
+#include "Resources/Voxels/Chunk.h"
+
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace vengine {
+
+/* Results of meshing one fixture, all values are averages per chunk */
+struct MesherStats {
+	double chunksPerSecond;
+	double quads;
+	double vertices;
+	double bytes;		/* Bytes of the vertices */
+	double allocations;	/* Heap allocations made while meshing, with mesh reused like octree does */
+};
+
+/* Messages and results of the checks. With CSV output they go to stderr, so stdout has only CSV rows. */
+static std::ostream* logStream = &std::cout;
+
+/* Mesh all chunks given number of times and measure meshing speed and size of the meshes */
+static MesherStats measureMesher(std::vector<Chunk*>& chunks, Chunk::Mesher mesher, int rounds)
+{
+	VoxelMesh mesh;
+	MesherStats stats;
+
+	/* Warm up scratch buffers, so only meshing is measured. Size of the meshes is taken from this round. */
+	size_t quads = 0;
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		chunks[i]->GenerateMesh(&mesh, mesher);
+		quads += mesh.GetQuadsNumber();
+	}
+	stats.quads = (double)quads / chunks.size();
+	stats.vertices = 4.0 * stats.quads;
+	stats.bytes = stats.vertices * sizeof(VoxelVertex);
+
+	AllocationCounter::Start();
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int round = 0; round < rounds; ++round)
+		for (size_t i = 0; i < chunks.size(); ++i)
+			chunks[i]->GenerateMesh(&mesh, mesher);
+	std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+	uint64_t allocations = AllocationCounter::Stop();
+
+	stats.chunksPerSecond = chunks.size() * rounds / elapsed.count();
+	stats.allocations = (double)allocations / (chunks.size() * rounds);
+	return stats;
+}
+
+/* Check if both meshers are giving the same result for all chunks */
+static bool compareMeshers(std::vector<Chunk*>& chunks)
+{
+	VoxelMesh greedy, binary;
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		chunks[i]->GenerateMesh(&greedy, Chunk::GREEDY);
+		chunks[i]->GenerateMesh(&binary, Chunk::BINARY);
+
+		if (greedy.GetVertices() != binary.GetVertices()) {
+			*logStream << "Meshers are giving different result for " << chunks[i]->GetName() << "\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+* Edit single voxels and update meshes of the chunks with UpdateMesh, like octree does for player edits. After each edit
+* updated mesh must be the same as the one generated from scratch. Some edits are changing neighbours lying next to the faces.
+*/
+static bool compareUpdates(std::vector<Chunk*>& chunks, int edits)
+{
+	std::mt19937 random(312538u);
+	VoxelMesh updated, expected;
+	bool same = true;
+	double updateTime = 0.0;
+	double generateTime = 0.0;
+
+	for (size_t i = 0; i < chunks.size() && same; ++i) {
+		Chunk chunk(*chunks[i]);
+		Chunk::Border border;
+		chunk.GenerateMesh(&updated, border);
+
+		for (int edit = 0; edit < edits; ++edit) {
+			if (random() % 8 == 0) {
+				int dir = random() % 3;
+				int front = random() % 2;
+				border.layers[dir][front][random() % Chunk::dimension] ^= (Chunk::Row)((Chunk::Row)1 << (random() % Chunk::dimension));
+				chunk.InvalidateFace(dir, front != 0);
+			}
+			else {
+				chunk.SetLocal(random() % Chunk::dimension, random() % Chunk::dimension, random() % Chunk::dimension,
+							   random() % 2 ? (unsigned char)(random() % Voxel::NUM_TYPES + 1) : Voxel::NONE);
+			}
+
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			chunk.UpdateMesh(&updated, border);
+			std::chrono::high_resolution_clock::time_point middle = std::chrono::high_resolution_clock::now();
+			chunk.GenerateMesh(&expected, border);
+			std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+
+			updateTime += std::chrono::duration<double>(middle - start).count();
+			generateTime += std::chrono::duration<double>(end - middle).count();
+
+			if (updated.GetVertices() != expected.GetVertices()) {
+				*logStream << "Updated mesh is different after edit " << edit << " of " << chunks[i]->GetName() << "\n";
+				same = false;
+				break;
+			}
+		}
+	}
+
+	*logStream << "  single voxel edits: " << generateTime / updateTime << "x faster than generating whole mesh\n";
+	return same;
+}
+
+/*
+* Mesh chunks through the mesh cache, like octree does, and report how many meshes were shared.
+* Shared mesh must be the same as the one generated for the chunk.
+*/
+static bool checkCache(std::vector<Chunk*>& chunks)
+{
+	MeshCache cache;
+	std::vector<VoxelMesh*> meshes;
+	VoxelMesh expected;
+	bool same = true;
+
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		Chunk::Border border;
+		MeshCache::Key key = MeshCache::GetKey(*chunks[i], border);
+		VoxelMesh* mesh = cache.Acquire(key);
+		if (mesh == nullptr) {
+			mesh = new VoxelMesh;
+			chunks[i]->GenerateMesh(mesh, border);
+			cache.Insert(key, mesh);
+		}
+		else {
+			chunks[i]->GenerateMesh(&expected, border);
+			if (expected.GetVertices() != mesh->GetVertices()) {
+				*logStream << "Cached mesh is different for " << chunks[i]->GetName() << "\n";
+				same = false;
+			}
+		}
+		meshes.push_back(mesh);
+	}
+
+	for (size_t i = 0; i < meshes.size(); ++i)
+		cache.Release(meshes[i]);
+
+	*logStream << "  mesh cache: " << 100.0 * cache.GetHitRate() << "% hits, " << cache.GetSize() << " meshes\n";
+	return same;
+}
+
+static void printStats(const char* fixture, const char* mesher, size_t chunks, const MesherStats& stats, bool csv)
+{
+	if (csv) {
+		/* Allocations column is left empty when they are not counted */
+		std::cout << fixture << "," << mesher << "," << Chunk::dimension << "," << chunks << "," << stats.chunksPerSecond << ","
+				  << stats.quads << "," << stats.vertices << "," << stats.bytes << ",";
+		if (AllocationCounter::IsEnabled())
+			std::cout << stats.allocations;
+		std::cout << "\n";
+	}
+	else {
+		std::cout << "  " << mesher << ": " << stats.chunksPerSecond << " chunks/s, " << stats.quads << " quads, "
+				  << stats.vertices << " vertices, " << stats.bytes << " bytes";
+		if (AllocationCounter::IsEnabled())
+			std::cout << ", " << stats.allocations << " allocations per chunk";
+		std::cout << "\n";
+	}
+}
+
+static void runFixture(const char* name, std::vector<Chunk*>& chunks, int rounds, bool csv, bool* same)
+{
+	*same = compareMeshers(chunks) && *same;
+
+	MesherStats greedy = measureMesher(chunks, Chunk::GREEDY, rounds);
+	MesherStats binary = measureMesher(chunks, Chunk::BINARY, rounds);
+
+	if (!csv)
+		std::cout << name << ": " << chunks.size() << " chunks\n";
+	printStats(name, "greedy", chunks.size(), greedy, csv);
+	printStats(name, "binary", chunks.size(), binary, csv);
+
+	*logStream << name << ": binary mesher x" << binary.chunksPerSecond / greedy.chunksPerSecond << " faster than greedy\n";
+	*same = compareUpdates(chunks, 50) && *same;
+	*same = checkCache(chunks) && *same;
+}
+
+/* Fill chunk using given function of local coordinates returning voxel type */
+template <class Function>
+static Chunk* makeChunk(const Vector3& offset, Function type)
+{
+	Chunk* chunk = new Chunk(offset);
+	for (int z = 0; z < Chunk::dimension; ++z)
+		for (int y = 0; y < Chunk::dimension; ++y)
+			for (int x = 0; x < Chunk::dimension; ++x)
+				chunk->SetLocal(x, y, z, type(x, y, z));
+	chunk->Compact();
+	return chunk;
+}
+
+static Vector3 fixtureOffset(int i)
+{
+	return Vector3(float(i * Chunk::dimension), 0.0f, 0.0f);
+}
+
+/* Surface chunks generated the same way as the world is */
+static void makeTerrain(std::vector<Chunk*>* chunks)
+{
+	TerrainGenerator terrainGen(0, 5, 1);
+	terrainGen.SetSmoothness(256);
+	terrainGen.SetDetails(1);
+	terrainGen.SetSpread(32);
+	terrainGen.SetSeed(312538u);
+	for (int z = 0; z < 4; ++z) {
+		for (int y = -2; y < 2; ++y) {
+			for (int x = 0; x < 4; ++x) {
+				Chunk* chunk = new Chunk((float)Chunk::dimension * Vector3(float(x), float(y), float(z)));
+				if (terrainGen.GetChunk(chunk))
+					chunks->push_back(chunk);
+				else
+					delete chunk;
+			}
+		}
+	}
+}
+
+/* Flat ground in the middle of the chunk - stone, dirt and one layer of grass */
+static void makeFlat(std::vector<Chunk*>* chunks)
+{
+	const int ground = Chunk::dimension / 2;
+	chunks->push_back(makeChunk(fixtureOffset(0), [ground](int, int y, int) {
+		return (unsigned char)(y < ground - 3 ? Voxel::STONE : y < ground ? Voxel::DIRT : y == ground ? Voxel::GRASS : Voxel::NONE);
+	}));
+}
+
+/* Worst case for every mesher - no two neighbouring voxels are solid, so each solid voxel has six quads */
+static void makeCheckerboard(std::vector<Chunk*>* chunks)
+{
+	chunks->push_back(makeChunk(fixtureOffset(0), [](int x, int y, int z) {
+		return (unsigned char)((x + y + z) % 2 ? Voxel::STONE : Voxel::NONE);
+	}));
+}
+
+/* Chunk filled with one opaque type, meshed as a shell */
+static void makeUniform(std::vector<Chunk*>* chunks)
+{
+	Chunk* chunk = new Chunk(fixtureOffset(0));
+	chunk->Fill(Voxel::STONE);
+	chunks->push_back(chunk);
+}
+
+/* Few scattered voxels, like caves or floating details */
+static void makeSparse(std::vector<Chunk*>* chunks)
+{
+	std::mt19937 random(312538u);
+	for (int i = 0; i < 8; ++i) {
+		chunks->push_back(makeChunk(fixtureOffset(i), [&random](int, int, int) {
+			return (unsigned char)(random() % 50 == 0 ? (unsigned char)(random() % Voxel::NUM_TYPES + 1) : Voxel::NONE);
+		}));
+	}
+}
+
+/* Tree crowns - mostly transparent leaves around wood, faces between leaves are not culled */
+static void makeLeaves(std::vector<Chunk*>* chunks)
+{
+	std::mt19937 random(312538u);
+	const int middle = Chunk::dimension / 2;
+	for (int i = 0; i < 8; ++i) {
+		chunks->push_back(makeChunk(fixtureOffset(i), [&random, middle](int x, int y, int z) {
+			if (x == middle && z == middle)
+				return (unsigned char)Voxel::WOOD;
+			return (unsigned char)(random() % 4 != 0 ? Voxel::LEAFS : Voxel::NONE);
+		}));
+	}
+}
+
+/* Worst case for greedy meshing - a lot of small faces with different types, including transparent ones */
+static void makeNoise(std::vector<Chunk*>* chunks)
+{
+	std::mt19937 random(312538u);
+	for (int i = 0; i < 16; ++i) {
+		chunks->push_back(makeChunk(fixtureOffset(i), [&random](int, int, int) {
+			return (unsigned char)(random() % 2 ? (unsigned char)(random() % Voxel::NUM_TYPES + 1) : Voxel::NONE);
+		}));
+	}
+}
+
+/*
+* Edit chunks on this thread while workers are meshing their copies and take finished meshes the same way
+* as octree does. At the end last taken mesh of each chunk must be the same as the one generated from its final state.
+*/
+static bool stressMeshWorkers(int threadsNumber)
+{
+	const int chunksNumber = 8;
+	const int rounds = 2000;
+	std::mt19937 random(312538u);
+
+	std::vector<Chunk*> chunks;
+	std::vector<VoxelMesh*> meshes;
+	for (int i = 0; i < chunksNumber; ++i) {
+		chunks.push_back(new Chunk(Vector3(float(i * Chunk::dimension), 0.0f, 0.0f)));
+		meshes.push_back(new VoxelMesh);
+	}
+
+	MeshWorkers workers;
+	workers.Start(threadsNumber);
+
+	MeshWorkers::Result result;
+	for (int round = 0; round < rounds; ++round) {
+		Chunk* chunk = chunks[random() % chunksNumber];
+		for (int i = 0; i < 64; ++i)
+			chunk->SetLocal(random() % Chunk::dimension, random() % Chunk::dimension, random() % Chunk::dimension,
+							random() % 2 ? (unsigned char)(random() % Voxel::NUM_TYPES + 1) : Voxel::NONE);
+
+		/* Sometimes jobs of the chunk are cancelled, like when octree is deleting it */
+		if (random() % 16 == 0)
+			workers.Cancel(chunk);
+		workers.Schedule(chunk, Chunk::Border());
+
+		while (workers.Pop(&result)) {
+			size_t index = std::find(chunks.begin(), chunks.end(), result.chunk) - chunks.begin();
+			meshes[index]->SwapVertices(result.mesh);
+			workers.Release(result.mesh);
+		}
+	}
+
+	workers.Wait();
+	while (workers.Pop(&result)) {
+		size_t index = std::find(chunks.begin(), chunks.end(), result.chunk) - chunks.begin();
+		meshes[index]->SwapVertices(result.mesh);
+		workers.Release(result.mesh);
+	}
+
+	bool same = true;
+	VoxelMesh expected;
+	for (int i = 0; i < chunksNumber; ++i) {
+		chunks[i]->GenerateMesh(&expected, Chunk::Border());
+		if (expected.GetVertices() != meshes[i]->GetVertices())
+			same = false;
+
+		delete chunks[i];
+		delete meshes[i];
+	}
+
+	*logStream << "Mesh workers stress, " << threadsNumber << " threads: " << (same ? "OK" : "FAILED") << "\n";
+	return same;
+}
+
+/* Stop workers with jobs still waiting, their chunks must not stay pending and must be meshed again after restart */
+static bool restartMeshWorkers()
+{
+	const int chunksNumber = 64;
+
+	std::vector<Chunk*> chunks;
+	for (int i = 0; i < chunksNumber; ++i) {
+		chunks.push_back(new Chunk(Vector3(float(i * Chunk::dimension), 0.0f, 0.0f)));
+		chunks.back()->SetLocal(i % Chunk::dimension, 0, 0, Voxel::STONE);
+	}
+
+	MeshWorkers workers;
+	workers.Start(1);
+	for (int i = 0; i < chunksNumber; ++i)
+		workers.Schedule(chunks[i], Chunk::Border());
+	workers.Stop();
+
+	MeshWorkers::Result result;
+	while (workers.Pop(&result))
+		workers.Release(result.mesh);
+
+	bool same = true;
+	for (int i = 0; i < chunksNumber; ++i)
+		if (workers.IsPending(chunks[i]))
+			same = false;
+
+	workers.Start(1);
+	workers.Schedule(chunks[0], Chunk::Border());
+	workers.Wait();
+	if (!workers.Pop(&result) || result.chunk != chunks[0] || result.mesh->GetQuadsNumber() != 6)
+		same = false;
+	else
+		workers.Release(result.mesh);
+
+	for (int i = 0; i < chunksNumber; ++i)
+		delete chunks[i];
+
+	*logStream << "Mesh workers restart: " << (same ? "OK" : "FAILED") << "\n";
+	return same;
+}
+
+/*
+* Pack vertices with each field at 0 and at the highest value, while all other fields have the opposite value,
+* on every side. Unpacked values must be the same, so no field is cut or leaking into its neighbour.
+*/
+static bool checkVertexPacking()
+{
+	const int fields = 8;
+	const int sideField = 3;
+
+	bool same = true;
+	for (int side = 0; side < 6; ++side) {
+		for (int field = 0; field < fields; ++field) {
+			if (field == sideField)
+				continue;
+
+			for (int low = 0; low < 2; ++low) {
+				int values[fields];
+				for (int i = 0; i < fields; ++i)
+					values[i] = (i == field) == (low == 1) ? 0 : VoxelVertex::maxValue;
+				values[sideField] = side;
+
+				VoxelVertex vertex = VoxelVertex::Pack(values[0], values[1], values[2], values[3], values[4], values[5], values[6], values[7]);
+				int unpacked[fields];
+				vertex.Unpack(&unpacked[0], &unpacked[1], &unpacked[2], &unpacked[3], &unpacked[4], &unpacked[5], &unpacked[6], &unpacked[7]);
+
+				for (int i = 0; i < fields; ++i) {
+					if (unpacked[i] != values[i]) {
+						*logStream << "Field " << i << " of the vertex is " << unpacked[i] << " instead of " << values[i]
+							<< ", side " << side << ", field " << field << (low ? " low" : " high") << "\n";
+						same = false;
+					}
+				}
+			}
+		}
+	}
+
+	*logStream << "Vertex packing: " << (same ? "OK" : "FAILED") << "\n";
+	return same;
+}
+
+/* Indices of quads not starting from the first one must follow the shared pattern shifted by 4 vertices per quad */
+static bool checkQuadIndices()
+{
+	const uint32_t pattern[6] = { 2, 3, 0, 0, 1, 2 };
+	const uint32_t first = 5;
+	const uint32_t quadsNumber = 3;
+
+	uint32_t indices[6 * quadsNumber];
+	VoxelVertex::FillQuadIndices(indices, first, quadsNumber);
+
+	bool same = true;
+	for (uint32_t quad = 0; quad < quadsNumber; ++quad) {
+		for (int i = 0; i < 6; ++i) {
+			uint32_t expected = 4 * (first + quad) + pattern[i];
+			if (indices[6 * quad + i] != expected) {
+				*logStream << "Index " << i << " of quad " << first + quad << " is " << indices[6 * quad + i] << " instead of " << expected << "\n";
+				same = false;
+			}
+		}
+	}
+
+	*logStream << "Quad indices: " << (same ? "OK" : "FAILED") << "\n";
+	return same;
+}
+
+int runMeshingBenchmark(bool csv)
+{
+	/* Fixtures with their number of rounds, quick ones are repeated more to get stable results */
+	struct Fixture {
+		const char* name;
+		void (*make)(std::vector<Chunk*>* chunks);
+		int rounds;
+	};
+	const Fixture fixtures[] = {
+		{ "terrain", makeTerrain, 10 },
+		{ "flat", makeFlat, 200 },
+		{ "checkerboard", makeCheckerboard, 20 },
+		{ "uniform", makeUniform, 1000 },
+		{ "sparse", makeSparse, 50 },
+		{ "leaves", makeLeaves, 10 },
+		{ "noise", makeNoise, 10 },
+	};
+
+	logStream = csv ? &std::cerr : &std::cout;
+	bool same = true;
+
+	*logStream << "Meshing benchmark, chunk dimension " << Chunk::dimension << "\n";
+	if (csv)
+		std::cout << "fixture,mesher,dimension,chunks,chunks_per_second,quads_per_chunk,vertices_per_chunk,bytes_per_chunk,allocations_per_chunk\n";
+
+	for (size_t i = 0; i < sizeof(fixtures) / sizeof(fixtures[0]); ++i) {
+		std::vector<Chunk*> chunks;
+		fixtures[i].make(&chunks);
+		if (!chunks.empty())
+			runFixture(fixtures[i].name, chunks, fixtures[i].rounds, csv, &same);
+
+		for (size_t j = 0; j < chunks.size(); ++j)
+			delete chunks[j];
+	}
+
+	same = stressMeshWorkers(0) && same;
+	same = stressMeshWorkers(4) && same;
+	same = restartMeshWorkers() && same;
+	same = checkVertexPacking() && same;
+	same = checkQuadIndices() && same;
+
+	*logStream << (same ? "All checks passed\n" : "Some checks FAILED\n");
+	return same ? 0 : VE_FAULT;
+}
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+namespace vengine {
+
+/*
+* Measure greedy and binary mesher on reproducible fixtures: terrain from the world generator, flat ground, checkerboard,
+* uniform, sparse, leaves and random noise chunks. For each of them chunks per second and average quads, vertices, bytes
+* and heap allocations per chunk are reported. Allocations are counted only in builds defining VE_COUNT_ALLOCATIONS,
+* like the Benchmark configuration. No window nor OpenGL context is needed.
+*
+* Results are also checked: both meshers must give the same vertices, meshes updated after single voxel edits and
+* meshes shared through the mesh cache must be the same as generated from scratch, and chunks meshed by mesh workers
+* while they are edited must end with up to date meshes. Stopped workers must not leave chunks pending.
+* Packed voxel vertices must unpack to the same values and quad indices must follow the pattern shared by all meshes.
+*/
+int runMeshingBenchmark(bool csv = false);
+
+}
@@ -0,0 +1,343 @@
+#include "NoiseBenchmark.h"
+
+#include "Errors.h"
+#include "Math/NoiseGraph.h"
+#include "Math/NoiseLattice.h"
+#include "Math/PerlinNoise.h"
+#include "Math/SimplexNoise.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace vengine {
+
+/* Check if grids and points of random size, position and scale are the same as points computed one by one */
+static bool compareGrids(const Noise& noise, std::ostream& log)
+{
+	std::mt19937 random(312538u);
+	const float scales[] = { 256.0f, 32.0f, 7.3f, 1.0f, 0.37f };
+	std::vector<float> grid;
+
+	for (int test = 0; test < 500; ++test) {
+		float x0 = (float)((int)(random() % 100000) - 50000);
+		float y0 = (float)((int)(random() % 100000) - 50000);
+		float z0 = (float)(random() % 1000) / 100.0f;
+		float scale = scales[random() % 5];
+		int countX = 1 + random() % 40;
+		int countY = 1 + random() % 40;
+		int countZ = 1 + random() % 4;
+
+		grid.resize(countX * countY * countZ);
+		noise.FillGrid3D(x0, y0, z0, scale, countX, countY, countZ, grid.data());
+		for (int k = 0; k < countZ; ++k) {
+			for (int j = 0; j < countY; ++j) {
+				for (int i = 0; i < countX; ++i) {
+					float expected = noise.GetNoise((x0 + i) / scale, (y0 + j) / scale, (z0 + k) / scale);
+					if (memcmp(&expected, &grid[i + countX * (j + countY * k)], sizeof(float)) != 0) {
+						log << "Noise grid is different at (" << (x0 + i) / scale << ", " << (y0 + j) / scale << ", "
+							<< (z0 + k) / scale << "): " << grid[i + countX * (j + countY * k)] << " instead of " << expected << "\n";
+						return false;
+					}
+				}
+			}
+		}
+
+		/* Planes are checked with all their points passed at once as well */
+		grid.resize(2 * countX * countY);
+		noise.FillGrid2D(x0, y0, z0, scale, countX, countY, grid.data());
+		std::vector<float> x(countX * countY);
+		std::vector<float> y(countX * countY);
+		for (int j = 0; j < countY; ++j) {
+			for (int i = 0; i < countX; ++i) {
+				x[i + countX * j] = (x0 + i) / scale;
+				y[i + countX * j] = (y0 + j) / scale;
+			}
+		}
+		noise.FillPoints(x.data(), y.data(), z0, countX * countY, grid.data() + countX * countY);
+
+		for (int i = 0; i < countX * countY; ++i) {
+			float expected = noise.GetPlaneNoise(x[i], y[i], z0);
+			if (memcmp(&expected, &grid[i], sizeof(float)) != 0 || memcmp(&expected, &grid[i + countX * countY], sizeof(float)) != 0) {
+				log << "Noise plane " << z0 << " is different at (" << x[i] << ", " << y[i] << "): " << grid[i] << " and "
+					<< grid[i + countX * countY] << " instead of " << expected << "\n";
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/* Shape with every kind of layer: smooth hills, warped ridges with curve and fine details with many octaves */
+static NoiseGraph makeShape()
+{
+	NoiseGraph shape;
+
+	NoiseLayer hills;
+	hills.octaves = 3;
+	hills.scale = 256.0f;
+	hills.z = 0.2f;
+	shape.AddLayer(hills);
+
+	NoiseLayer ridges;
+	ridges.type = NoiseLayer::RIDGED;
+	ridges.octaves = 5;
+	ridges.scale = 128.0f;
+	ridges.z = 0.5f;
+	ridges.amplitude = 0.5f;
+	ridges.warp = 24.0f;
+	ridges.warpScale = 64.0f;
+	ridges.curve = { -1.0f, -0.8f, -0.2f, 0.6f, 1.0f };
+	shape.AddLayer(ridges);
+
+	NoiseLayer details;
+	details.octaves = 8;
+	details.scale = 32.0f;
+	details.z = 0.3f;
+	details.amplitude = 0.1f;
+	shape.AddLayer(details);
+
+	return shape;
+}
+
+/* Value of the shape computed point by point with GetPlaneNoise, the way naive layering would do it */
+static float getShapeValue(const Noise& noise, const NoiseGraph& shape, float x, float z)
+{
+	float sum = 0.0f;
+	const std::vector<NoiseLayer>& layers = shape.GetLayers();
+
+	for (size_t l = 0; l < layers.size(); ++l) {
+		const NoiseLayer& layer = layers[l];
+
+		float px = x;
+		float pz = z;
+		if (layer.warp != 0.0f) {
+			px = x + layer.warp * noise.GetPlaneNoise(x / layer.warpScale, z / layer.warpScale, layer.z + 0.43f);
+			pz = z + layer.warp * noise.GetPlaneNoise(x / layer.warpScale, z / layer.warpScale, layer.z + 0.71f);
+		}
+
+		float value = 0.0f;
+		float total = 0.0f;
+		float amplitude = 1.0f;
+		float scale = layer.scale;
+		for (int k = 0; k < layer.octaves; ++k) {
+			float octave = noise.GetPlaneNoise(px / scale, pz / scale, layer.z + k * 0.17f);
+			if (layer.type == NoiseLayer::RIDGED)
+				octave = (1.0f - std::abs(octave)) * (1.0f - std::abs(octave));
+			value += amplitude * octave;
+			total += amplitude;
+			amplitude *= layer.gain;
+			scale /= layer.lacunarity;
+		}
+		value /= total;
+		if (layer.type == NoiseLayer::RIDGED)
+			value = 2.0f * value - 1.0f;
+
+		if (!layer.curve.empty()) {
+			float t = (std::min(std::max(value, -1.0f), 1.0f) + 1.0f) * 0.5f * (layer.curve.size() - 1);
+			int i = std::min((int)t, (int)layer.curve.size() - 2);
+			value = layer.curve[i] + (t - i) * (layer.curve[i + 1] - layer.curve[i]);
+		}
+		sum += layer.amplitude * value;
+	}
+
+	return sum;
+}
+
+/* Compare shape filled by the graph with the naive one and measure both, results are added to the output */
+static bool runShape(const char* name, const Noise& noise, bool csv, std::ostream& log)
+{
+	const int size = 16;
+	const int planes = 2000;
+	NoiseGraph shape = makeShape();
+	std::vector<float> plane(size * size);
+	float sum = 0.0f;
+	bool same = true;
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int p = 0; p < planes; ++p) {
+		float x0 = (float)(p * size);
+		for (int j = 0; j < size; ++j)
+			for (int i = 0; i < size; ++i)
+				plane[i + size * j] = getShapeValue(noise, shape, x0 + i, (float)j);
+		sum += plane[p % (size * size)];
+	}
+	std::chrono::duration<double> naive = std::chrono::high_resolution_clock::now() - start;
+
+	std::vector<float> expected(plane);
+	start = std::chrono::high_resolution_clock::now();
+	for (int p = 0; p < planes; ++p) {
+		shape.Fill(noise, (float)(p * size), 0.0f, size, size, plane.data());
+		sum += plane[p % (size * size)];
+	}
+	std::chrono::duration<double> graph = std::chrono::high_resolution_clock::now() - start;
+
+	/* Order of additions differs between the two, so values are compared with tolerance */
+	for (int i = 0; i < size * size; ++i) {
+		if (std::abs(plane[i] - expected[i]) > 1e-5f) {
+			log << "Noise graph is different at point " << i << ": " << plane[i] << " instead of " << expected[i] << "\n";
+			same = false;
+			break;
+		}
+	}
+
+	double points = (double)planes * size * size;
+	if (csv) {
+		std::cout << name << " NoiseGraph naive," << points / naive.count() << "\n";
+		std::cout << name << " NoiseGraph," << points / graph.count() << "\n";
+	}
+	else {
+		std::cout << "  " << name << " noise graph, point by point: " << points / naive.count() << " points/s\n";
+		std::cout << "  " << name << " noise graph: " << points / graph.count() << " points/s (x" << naive.count() / graph.count() << ")\n";
+	}
+
+	log << name << " noise graph " << (same ? "OK" : "FAILED") << " (checksum " << sum << ")\n";
+	return same;
+}
+
+/* Compare boxes interpolated from the lattice with points interpolated one by one and measure them against 3D noise */
+static bool runLattice(const char* name, const Noise& noise, bool csv, std::ostream& log)
+{
+	const int size = 16;
+	const int boxes = 2000;
+	const float scale = 48.0f;
+	std::mt19937 random(312538u);
+	std::vector<float> box(size * size * size);
+	float sum = 0.0f;
+	bool same = true;
+
+	for (int test = 0; test < 100 && same; ++test) {
+		int x0 = ((int)(random() % 100000) - 50000) * NoiseLattice::step;
+		int y0 = ((int)(random() % 1000) - 500) * NoiseLattice::step;
+		int z0 = ((int)(random() % 100000) - 50000) * NoiseLattice::step;
+
+		NoiseLattice::Fill(noise, x0, y0, z0, scale, size, box.data());
+		for (int i = 0; i < size * size * size && same; ++i) {
+			int x = x0 + i % size;
+			int y = y0 + (i / size) % size;
+			int z = z0 + i / (size * size);
+			float expected = NoiseLattice::GetValue(noise, x, y, z, scale);
+			if (memcmp(&expected, &box[i], sizeof(float)) != 0) {
+				log << "Noise lattice is different at (" << x << ", " << y << ", " << z << "): " << box[i] << " instead of " << expected << "\n";
+				same = false;
+			}
+		}
+	}
+
+	/* Boxes of the chunk size, the way caves are generated */
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int b = 0; b < boxes / 10; ++b) {
+		for (int k = 0; k < size; ++k)
+			for (int j = 0; j < size; ++j)
+				for (int i = 0; i < size; ++i)
+					box[i + size * (j + size * k)] = noise.GetNoise((b * size + i) / scale, j / scale, k / scale);
+		sum += box[b % box.size()];
+	}
+	std::chrono::duration<double> voxels = std::chrono::high_resolution_clock::now() - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int b = 0; b < boxes; ++b) {
+		NoiseLattice::Fill(noise, b * size, 0, 0, scale, size, box.data());
+		sum += box[b % box.size()];
+	}
+	std::chrono::duration<double> lattice = std::chrono::high_resolution_clock::now() - start;
+
+	double voxelPoints = (double)boxes / 10 * size * size * size;
+	double latticePoints = (double)boxes * size * size * size;
+	if (csv) {
+		std::cout << name << " GetNoise 3D per voxel," << voxelPoints / voxels.count() << "\n";
+		std::cout << name << " NoiseLattice," << latticePoints / lattice.count() << "\n";
+	}
+	else {
+		std::cout << "  " << name << " 3D noise per voxel: " << voxelPoints / voxels.count() << " points/s\n";
+		std::cout << "  " << name << " noise lattice: " << latticePoints / lattice.count() << " points/s (x"
+				  << (latticePoints / lattice.count()) / (voxelPoints / voxels.count()) << ")\n";
+	}
+
+	log << name << " noise lattice " << (same ? "OK" : "FAILED") << " (checksum " << sum << ")\n";
+	return same;
+}
+
+/* Measure one backend: planes point by point and as grids, 3D noise point by point and the noise graph */
+static bool runBackend(const char* name, const Noise& noise, bool csv, std::ostream& log)
+{
+	const int size = 16;
+	const int planes = 20000;
+
+	bool same = compareGrids(noise, log);
+
+	/* Planes of the chunk columns, the same way as terrain generator is using them */
+	std::vector<float> plane(size * size);
+	float sum = 0.0f;
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for (int p = 0; p < planes; ++p) {
+		float x0 = (float)(p * size);
+		for (int j = 0; j < size; ++j)
+			for (int i = 0; i < size; ++i)
+				plane[i + size * j] = noise.GetPlaneNoise((x0 + i) / 256.0f, j / 256.0f, 0.2f);
+		sum += plane[p % (size * size)];
+	}
+	std::chrono::duration<double> scalar = std::chrono::high_resolution_clock::now() - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int p = 0; p < planes; ++p) {
+		noise.FillGrid2D((float)(p * size), 0.0f, 0.2f, 256.0f, size, size, plane.data());
+		sum += plane[p % (size * size)];
+	}
+	std::chrono::duration<double> grid = std::chrono::high_resolution_clock::now() - start;
+
+	/* Boxes of the same number of points, 3D noise has no grid kernel in simplex backend */
+	start = std::chrono::high_resolution_clock::now();
+	for (int p = 0; p < planes; ++p) {
+		float x0 = (float)(p * size);
+		for (int j = 0; j < size; ++j)
+			for (int i = 0; i < size; ++i)
+				plane[i + size * j] = noise.GetNoise((x0 + i) / 256.0f, j / 256.0f, (p % size) / 256.0f);
+		sum += plane[p % (size * size)];
+	}
+	std::chrono::duration<double> space = std::chrono::high_resolution_clock::now() - start;
+
+	double points = (double)planes * size * size;
+	if (csv) {
+		std::cout << name << " GetPlaneNoise," << points / scalar.count() << "\n";
+		std::cout << name << " FillGrid2D," << points / grid.count() << "\n";
+		std::cout << name << " GetNoise 3D," << points / space.count() << "\n";
+	}
+	else {
+		std::cout << "  " << name << " GetPlaneNoise: " << points / scalar.count() << " points/s\n";
+		std::cout << "  " << name << " FillGrid2D: " << points / grid.count() << " points/s (x" << scalar.count() / grid.count() << ")\n";
+		std::cout << "  " << name << " GetNoise 3D: " << points / space.count() << " points/s\n";
+	}
+
+	/* Sum is printed, so the loops cannot be removed by the compiler */
+	log << name << " noise grids " << (same ? "OK" : "FAILED") << " (checksum " << sum << ")\n";
+
+	same = runShape(name, noise, csv, log) && same;
+	same = runLattice(name, noise, csv, log) && same;
+	return same;
+}
+
+int runNoiseBenchmark(bool csv)
+{
+	std::ostream& log = csv ? std::cerr : std::cout;
+
+	PerlinNoise perlin(312538u);
+	SimplexNoise simplex(312538u);
+
+	if (csv)
+		std::cout << "method,pointsPerSecond\n";
+	else
+		std::cout << "Noise benchmark" << (Noise::IsVectorized() ? ", AVX2" : ", scalar only") << "\n";
+
+	bool same = runBackend("Perlin", perlin, csv, log);
+	same = runBackend("Simplex", simplex, csv, log) && same;
+	return same ? 0 : VE_FAULT;
+}
+
+}
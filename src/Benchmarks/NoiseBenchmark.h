@@ -0,0 +1,13 @@
+#pragma once
+
+namespace vengine {
+
+/*
+* Measure how many points per second of Perlin and simplex noise are computed one by one and as grids.
+* Grids must give exactly the same values as the points computed one by one. Terrain shape filled by the noise graph
+* is compared with the same shape computed point by point. Boxes interpolated from the noise lattice must be the same
+* as points interpolated one by one, they are measured against 3D noise computed for every point.
+*/
+int runNoiseBenchmark(bool csv = false);
+
+}
@@ -0,0 +1,391 @@
+#include "TerrainBenchmark.h"
+
+#include "Errors.h"
+#include "Engine/TerrainGenerator.h"
+#include "Math/MathFunctions.h"
+#include "Math/NoiseGraph.h"
+#include "Resources/Voxels/Chunk.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace vengine {
+
+/* Same size and settings as the world loaded by the engine */
+static const int worldChunks = 256 / Chunk::dimension;
+
+static void makeGenerator(TerrainGenerator* terrainGen)
+{
+	terrainGen->SetSeaOffset(0);
+	terrainGen->SetRockOffset(5);
+	terrainGen->SetRockSharpness(1);
+	terrainGen->SetSmoothness(256);
+	terrainGen->SetDetails(1);
+	terrainGen->SetSpread(32);
+	terrainGen->SetSeed(312538u);
+}
+
+static void makeWorld(std::vector<Chunk*>* chunks)
+{
+	const float half = worldChunks / 2.0f;
+	for (int z = 0; z < worldChunks; ++z)
+		for (int y = 0; y < worldChunks; ++y)
+			for (int x = 0; x < worldChunks; ++x)
+				chunks->push_back(new Chunk(Vector3((x - half) * Chunk::dimension, (y - half) * Chunk::dimension, (z - half) * Chunk::dimension)));
+}
+
+/* Fill chunks one by one, flag of each chunk is set to 1 if it is not empty */
+static void generateWorld(const TerrainGenerator& terrainGen, const std::vector<Chunk*>& chunks, std::vector<char>* filled)
+{
+	filled->assign(chunks.size(), 0);
+	for (size_t i = 0; i < chunks.size(); ++i)
+		(*filled)[i] = terrainGen.GetChunk(chunks[i]) ? 1 : 0;
+}
+
+/* Hash of all generated chunks in the order of the grid, empty chunks are included only by their flag */
+static uint64_t hashWorld(const std::vector<Chunk*>& chunks, const std::vector<char>& filled)
+{
+	uint64_t hash = 0;
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		hash = hashCombine(hash, (uint64_t)filled[i]);
+		if (filled[i])
+			hash = hashCombine(hash, chunks[i]->GetContentHash());
+	}
+	return hash;
+}
+
+/* Check if rock depths have the mean and deviation given to the generator */
+static bool checkRockDepths(float offset, float sharpness, std::ostream& log)
+{
+	TerrainGenerator terrainGen;
+	terrainGen.SetRockOffset(offset);
+	terrainGen.SetRockSharpness(sharpness);
+
+	const int size = 64;
+	double sum = 0.0;
+	double squares = 0.0;
+	for (int z = -size; z < size; ++z) {
+		for (int y = -size; y < size; ++y) {
+			for (int x = -size; x < size; ++x) {
+				double depth = terrainGen.GetRockDepth(x, y, z);
+				sum += depth;
+				squares += depth * depth;
+			}
+		}
+	}
+
+	/* Tolerances are about 5 standard errors for this number of samples */
+	double samples = 8.0 * size * size * size;
+	double mean = sum / samples;
+	double variance = squares / samples - mean * mean;
+	double expected = (double)sharpness * sharpness;
+	bool same = std::abs(mean - offset) < 0.01 * sharpness && std::abs(variance - expected) < 0.02 * expected;
+
+	log << "  rock depths: mean " << mean << " (" << offset << "), variance " << variance << " (" << expected << ")"
+		<< (same ? "" : " - WRONG") << "\n";
+	return same;
+}
+
+static void deleteWorld(std::vector<Chunk*>* chunks)
+{
+	for (size_t i = 0; i < chunks->size(); ++i)
+		delete (*chunks)[i];
+	chunks->clear();
+}
+
+/*
+* Columns of the world compared with golden hashes. Columns are given in voxels and aligned to the largest chunk
+* dimension, so hashes do not depend on VE_CHUNK_DIMENSION. They cover the surface and the rocks below it.
+*/
+static const int goldenSize = 64;
+static const int goldenBottom = -64;
+static const int goldenHeight = 128;
+
+struct GoldenColumn {
+	unsigned int seed;
+	TerrainGenerator::NoiseType noise;
+	bool shaped;	/* Terrain uses the noise graph instead of the default hills */
+	bool caves;
+	int x;
+	int z;
+	uint64_t hash;
+};
+
+/*
+* Hashes of the worlds players could have already explored. When a change of the generator is intended to change
+* the worlds, new hashes are printed by the benchmark and must be copied here.
+*/
+static const GoldenColumn goldenColumns[] = {
+	{ 312538u, TerrainGenerator::PERLIN, false, false, 0, 0, 0x6ef319ba6cccdcc3ull },
+	{ 312538u, TerrainGenerator::PERLIN, false, false, -4096, 1024, 0x3916b6d23d9643c0ull },
+	{ 312538u, TerrainGenerator::PERLIN, false, false, 65536, -131072, 0xcd111dc0a7ae6808ull },
+	{ 518331203u, TerrainGenerator::PERLIN, false, false, 0, 0, 0x94722ceffbc9297ull },
+	{ 518331203u, TerrainGenerator::PERLIN, false, false, -4096, 1024, 0x397bd5795d669a35ull },
+	{ 518331203u, TerrainGenerator::PERLIN, false, false, 65536, -131072, 0xd561fc879ef23d0ull },
+	{ 7u, TerrainGenerator::PERLIN, false, false, 0, 0, 0x945be89fcfdf34d5ull },
+	{ 7u, TerrainGenerator::PERLIN, false, false, 65536, -131072, 0xfe28ca81500d7a36ull },
+	{ 312538u, TerrainGenerator::PERLIN, true, false, 0, 0, 0x949dbc1a7ecf8131ull },
+	{ 312538u, TerrainGenerator::PERLIN, true, false, -4096, 1024, 0x2def3344c742d891ull },
+	{ 7u, TerrainGenerator::PERLIN, true, false, 65536, -131072, 0x70f4b2c68a82171dull },
+	{ 312538u, TerrainGenerator::SIMPLEX, false, false, 0, 0, 0x2ea5fc95f96bfc1bull },
+	{ 518331203u, TerrainGenerator::SIMPLEX, false, false, 65536, -131072, 0x73bd1a346b895b59ull },
+	{ 312538u, TerrainGenerator::SIMPLEX, true, false, -4096, 1024, 0x500b52f668c744e2ull },
+	{ 312538u, TerrainGenerator::PERLIN, false, true, 0, 0, 0x8e1708453be398a2ull },
+	{ 518331203u, TerrainGenerator::PERLIN, true, true, -4096, 1024, 0x6d58f7f8fdc0fd09ull },
+	{ 312538u, TerrainGenerator::SIMPLEX, false, true, 65536, -131072, 0xd0d706714630ab0eull }
+};
+
+/* Caves used by the golden columns and measured with the world */
+static void makeCaves(TerrainGenerator* terrainGen)
+{
+	terrainGen->SetCaves(48.0f, 0.35f, 24);
+}
+
+/* Warped ridges over smooth hills, so the noise graph is covered as well */
+static NoiseGraph makeShape()
+{
+	NoiseGraph shape;
+
+	NoiseLayer hills;
+	hills.octaves = 3;
+	hills.scale = 256.0f;
+	shape.AddLayer(hills);
+
+	NoiseLayer ridges;
+	ridges.type = NoiseLayer::RIDGED;
+	ridges.octaves = 5;
+	ridges.scale = 128.0f;
+	ridges.z = 0.5f;
+	ridges.amplitude = 0.5f;
+	ridges.warp = 24.0f;
+	ridges.curve = { -1.0f, -0.5f, 0.5f, 1.0f };
+	shape.AddLayer(ridges);
+
+	return shape;
+}
+
+/* Hash of voxel types of the column in the order of world coordinates, independent of the chunk dimension */
+static uint64_t hashColumn(const TerrainGenerator& terrainGen, int x0, int z0)
+{
+	const int dim = Chunk::dimension;
+	const int countXZ = goldenSize / dim;
+	const int countY = goldenHeight / dim;
+
+	std::vector<Chunk*> chunks;
+	std::vector<char> filled;
+	for (int y = 0; y < countY; ++y)
+		for (int z = 0; z < countXZ; ++z)
+			for (int x = 0; x < countXZ; ++x)
+				chunks.push_back(new Chunk(Vector3((float)(x0 + x * dim), (float)(goldenBottom + y * dim), (float)(z0 + z * dim))));
+	generateWorld(terrainGen, chunks, &filled);
+
+	uint64_t hash = 0;
+	for (int y = 0; y < goldenHeight; ++y) {
+		for (int z = 0; z < goldenSize; ++z) {
+			for (int x = 0; x < goldenSize; ++x) {
+				const Chunk* chunk = chunks[x / dim + countXZ * (z / dim + countXZ * (y / dim))];
+				hash = hashCombine(hash, chunk->GetLocal(x % dim, y % dim, z % dim).GetType());
+			}
+		}
+	}
+
+	deleteWorld(&chunks);
+	return hash;
+}
+
+/* Check that generated worlds did not change, all differences are reported */
+static bool checkGoldenColumns(std::ostream& log)
+{
+	NoiseGraph shape = makeShape();
+	bool same = true;
+
+	for (size_t i = 0; i < sizeof(goldenColumns) / sizeof(goldenColumns[0]); ++i) {
+		const GoldenColumn& column = goldenColumns[i];
+
+		TerrainGenerator terrainGen;
+		makeGenerator(&terrainGen);
+		terrainGen.SetSeed(column.seed);
+		terrainGen.SetNoiseType(column.noise);
+		if (column.shaped)
+			terrainGen.SetShape(shape);
+		if (column.caves)
+			makeCaves(&terrainGen);
+
+		uint64_t hash = hashColumn(terrainGen, column.x, column.z);
+		if (hash != column.hash) {
+			log << "  column (" << column.x << ", " << column.z << ") of seed " << column.seed
+				<< (column.noise == TerrainGenerator::SIMPLEX ? " with simplex noise" : "") << (column.shaped ? " with shape" : "") << (column.caves ? " with caves" : "")
+				<< " changed: 0x" << std::hex << hash << "ull instead of 0x" << column.hash << "ull" << std::dec << "\n";
+			same = false;
+		}
+	}
+
+	log << "  golden columns: " << (same ? "same" : "CHANGED") << "\n";
+	return same;
+}
+
+/* Measure how long it takes to compute height maps of all columns of the world, without the cache */
+static double timeHeightMaps(TerrainGenerator& terrainGen, float* sum)
+{
+	terrainGen.GetHeightMapCache().Clear();
+	HeightMapCache::HeightMap heightMap;
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	const int half = worldChunks / 2;
+	for (int z = 0; z < worldChunks; ++z) {
+		for (int x = 0; x < worldChunks; ++x) {
+			terrainGen.GetHeightMap((x - half) * Chunk::dimension, (z - half) * Chunk::dimension, &heightMap);
+			*sum += (float)heightMap.maxHeight;
+		}
+	}
+	std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start;
+
+	return time.count();
+}
+
+/*
+* Measure stages of the generation separately on one thread: noise samples with GetNoise, height maps of all
+* columns of the world and filling chunks when all height maps are already cached. Height maps are also measured
+* with the simplex backend and filling chunks with caves.
+*/
+static void measureStages(TerrainGenerator& terrainGen, bool csv, std::ostream& log)
+{
+	const int noiseSize = 1024;
+	float sum = 0.0f;
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	PerlinNoise noise(312538u);
+	for (int z = 0; z < noiseSize; ++z)
+		for (int x = 0; x < noiseSize; ++x)
+			sum += noise.GetNoise(x / 256.0f, z / 256.0f, 0.2f);
+	std::chrono::duration<double> noiseTime = std::chrono::high_resolution_clock::now() - start;
+
+	TerrainGenerator simplexGen;
+	makeGenerator(&simplexGen);
+	simplexGen.SetNoiseType(TerrainGenerator::SIMPLEX);
+	double simplexTime = timeHeightMaps(simplexGen, &sum);
+
+	/* Height maps stay in the cache, so filling chunks does not compute noise */
+	double heightMapTime = timeHeightMaps(terrainGen, &sum);
+
+	std::vector<Chunk*> chunks;
+	std::vector<char> filled;
+	makeWorld(&chunks);
+	start = std::chrono::high_resolution_clock::now();
+	generateWorld(terrainGen, chunks, &filled);
+	std::chrono::duration<double> fillTime = std::chrono::high_resolution_clock::now() - start;
+	deleteWorld(&chunks);
+
+	TerrainGenerator cavesGen;
+	makeGenerator(&cavesGen);
+	makeCaves(&cavesGen);
+	timeHeightMaps(cavesGen, &sum);
+	makeWorld(&chunks);
+	start = std::chrono::high_resolution_clock::now();
+	generateWorld(cavesGen, chunks, &filled);
+	std::chrono::duration<double> cavesTime = std::chrono::high_resolution_clock::now() - start;
+	deleteWorld(&chunks);
+
+	double samples = (double)noiseSize * noiseSize;
+	double columns = (double)worldChunks * worldChunks;
+	double total = heightMapTime + fillTime.count();
+
+	if (csv) {
+		std::cout << "stage,seconds,perSecond\n";
+		std::cout << "noise," << noiseTime.count() << "," << samples / noiseTime.count() << "\n";
+		std::cout << "heightMaps," << heightMapTime << "," << columns / heightMapTime << "\n";
+		std::cout << "heightMaps simplex," << simplexTime << "," << columns / simplexTime << "\n";
+		std::cout << "voxelFill," << fillTime.count() << "," << filled.size() / fillTime.count() << "\n";
+		std::cout << "voxelFill caves," << cavesTime.count() << "," << filled.size() / cavesTime.count() << "\n";
+	}
+	else {
+		std::cout << "  GetNoise: " << samples / noiseTime.count() << " samples/s\n";
+		std::cout << "  height maps: " << heightMapTime << " s, " << columns / heightMapTime << " columns/s ("
+				  << 100.0 * heightMapTime / total << "%)\n";
+		std::cout << "  height maps with simplex noise: " << simplexTime << " s, " << columns / simplexTime << " columns/s (x"
+				  << heightMapTime / simplexTime << ")\n";
+		std::cout << "  voxel fill: " << fillTime.count() << " s, " << filled.size() / fillTime.count() << " chunks/s ("
+				  << 100.0 * fillTime.count() / total << "%)\n";
+		std::cout << "  voxel fill with caves: " << cavesTime.count() << " s, " << filled.size() / cavesTime.count() << " chunks/s\n";
+		std::cout << "  one thread: " << filled.size() / total << " chunks/s\n";
+	}
+
+	/* Sum is printed, so the loops cannot be removed by the compiler */
+	log << "  stages checksum " << sum << "\n";
+}
+
+int runTerrainBenchmark(bool csv)
+{
+	std::ostream& log = csv ? std::cerr : std::cout;
+	TerrainGenerator terrainGen;
+	makeGenerator(&terrainGen);
+
+	std::vector<Chunk*> chunks;
+	std::vector<char> filled;
+	bool same = true;
+
+	/* Reference world is generated on one thread from the last chunk to the first one, without cached height maps */
+	HeightMapCache& heightMaps = terrainGen.GetHeightMapCache();
+	heightMaps.SetMaxColumns(0);
+	makeWorld(&chunks);
+	filled.assign(chunks.size(), 0);
+	for (size_t i = chunks.size(); i-- > 0;)
+		filled[i] = terrainGen.GetChunk(chunks[i]) ? 1 : 0;
+	uint64_t expected = hashWorld(chunks, filled);
+	deleteWorld(&chunks);
+	heightMaps.SetMaxColumns(worldChunks * worldChunks);
+
+	log << "Terrain benchmark, " << worldChunks * worldChunks * worldChunks << " chunks of dimension " << Chunk::dimension << "\n";
+
+	/* Only surface chunks are generated voxel by voxel */
+	int types[3] = { 0, 0, 0 };
+	makeWorld(&chunks);
+	for (size_t i = 0; i < chunks.size(); ++i)
+		++types[terrainGen.ClassifyChunk(chunks[i]->GetOffset())];
+	deleteWorld(&chunks);
+	log << "  chunks: " << types[TerrainGenerator::EMPTY] << " empty, " << types[TerrainGenerator::SOLID] << " solid, "
+		<< types[TerrainGenerator::SURFACE] << " surface\n";
+
+	same = checkRockDepths(5.0f, 1.0f, log) && same;
+	same = checkRockDepths(7.0f, 2.5f, log) && same;
+	same = checkGoldenColumns(log) && same;
+	measureStages(terrainGen, csv, log);
+	if (csv)
+		std::cout << "seconds,chunksPerSecond,heightMapHitRate,noisePointsPerChunk\n";
+
+	/* World is generated in the order of the grid with cached height maps, it must be the same as the reference */
+	makeWorld(&chunks);
+	heightMaps.Clear();
+	HeightMapCache::Stats before = heightMaps.GetStats();
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	generateWorld(terrainGen, chunks, &filled);
+	std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start;
+
+	uint64_t hash = hashWorld(chunks, filled);
+	deleteWorld(&chunks);
+
+	/* Every missing height map needs three planes of noise */
+	HeightMapCache::Stats after = heightMaps.GetStats();
+	uint64_t misses = after.misses - before.misses;
+	double hitRate = 1.0 - (double)misses / filled.size();
+	double noisePoints = 3.0 * Chunk::dimension * Chunk::dimension * misses / filled.size();
+
+	if (csv)
+		std::cout << time.count() << "," << filled.size() / time.count() << "," << hitRate << "," << noisePoints << "\n";
+	else
+		std::cout << "  whole world: " << time.count() << " s, " << filled.size() / time.count() << " chunks/s, height maps "
+				  << 100.0 * hitRate << "% hits, " << noisePoints << " noise points per chunk\n";
+
+	if (hash != expected) {
+		log << "World generated in the order of the grid is different: " << std::hex << hash << " instead of " << expected << std::dec << "\n";
+		same = false;
+	}
+
+	log << "Terrain generation " << (same ? "OK" : "FAILED") << "\n";
+	return same ? 0 : VE_FAULT;
+}
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace vengine {
+
+/*
+* Measure how long it takes to generate the world loaded by the engine on one thread. Generated chunks must be
+* the same as chunks generated one by one in reversed order without the cache of height maps. Hit rate of the cache,
+* noise points computed per chunk and numbers of empty, solid and surface chunks are reported. Rock depths must have
+* the mean and variance given by the rock offset and sharpness. Columns of several seeds, with and without the noise
+* graph, must match golden hashes, so worlds already explored by players are not changed. Noise samples, height maps
+* and voxel filling are also timed separately.
+*/
+int runTerrainBenchmark(bool csv = false);
+
+}
@@ -0,0 +1,437 @@
+#include "WorldBenchmark.h"
+
+#include "Errors.h"
+#include "Engine/Octree.h"
+#include "Engine/TerrainGenerator.h"
+#include "Engine/WorldStreamer.h"
+#include "Resources/Voxels/Chunk.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace vengine {
+
+/* Resident area is smaller than in the engine, so the path crosses many chunks in short time */
+static const int radius = 4;
+static const int verticalRadius = 2;
+static const int hysteresis = 1;
+
+/* World loaded at once has the same size as in the engine */
+static const int loadRadius = 8;
+static const int loadVerticalRadius = 4;
+
+static const float stepLength = 4.0f;		/* Voxels travelled by the player in one frame */
+static const int maxSettleFrames = 20000;	/* Frames after which the streamer is considered stuck */
+
+/*
+* Path of the player in chunks. Player goes away from the start, so the edited chunks are left behind,
+* climbs and comes back, so chunks are removed and loaded again.
+*/
+static const float path[][3] = {
+	{ 0.5f, 0.5f, 0.5f },
+	{ 12.5f, 0.5f, 0.5f },
+	{ 12.5f, 1.5f, -15.5f },
+	{ -6.5f, 3.5f, -15.5f },
+	{ 0.5f, 0.5f, 0.5f }
+};
+static const int pathPoints = sizeof(path) / sizeof(path[0]);
+
+/* Chunks which can be resident at any point of the path, given by inclusive coordinates in chunks */
+struct Region {
+	int low[3];
+	int high[3];
+};
+
+/* Voxel changed by the player and its type after the change */
+struct Edit {
+	Vector3 coordinates;
+	unsigned char type;
+};
+
+struct FrameStats {
+	int frames;
+	double seconds;
+	double maxSeconds;	/* The longest frame */
+};
+
+/* Same settings as the world loaded by the engine */
+static void makeGenerator(TerrainGenerator* terrainGen)
+{
+	terrainGen->SetSeaOffset(0);
+	terrainGen->SetRockOffset(5);
+	terrainGen->SetRockSharpness(1);
+	terrainGen->SetSmoothness(256);
+	terrainGen->SetDetails(1);
+	terrainGen->SetSpread(32);
+	terrainGen->SetSeed(312538u);
+}
+
+static Vector3 getPathPoint(int i)
+{
+	return Vector3(path[i][0], path[i][1], path[i][2]) * (float)Chunk::dimension;
+}
+
+static Region getRegion()
+{
+	const int extension[3] = { radius + hysteresis + 1, verticalRadius + hysteresis + 1, radius + hysteresis + 1 };
+
+	Region region;
+	for (int axis = 0; axis < 3; ++axis) {
+		region.low[axis] = (int)std::floor(path[0][axis]);
+		region.high[axis] = region.low[axis];
+		for (int i = 1; i < pathPoints; ++i) {
+			region.low[axis] = std::min(region.low[axis], (int)std::floor(path[i][axis]));
+			region.high[axis] = std::max(region.high[axis], (int)std::floor(path[i][axis]));
+		}
+		region.low[axis] -= extension[axis];
+		region.high[axis] += extension[axis];
+	}
+	return region;
+}
+
+/* Check if chunk lies within radius extended by given number of chunks, the same way as the streamer does */
+static bool isInside(int x, int y, int z, const Vector3& position, int extension)
+{
+	int dx = x - (int)std::floor(position.x / Chunk::dimension);
+	int dy = y - (int)std::floor(position.y / Chunk::dimension);
+	int dz = z - (int)std::floor(position.z / Chunk::dimension);
+	int extended = radius + extension;
+
+	return dx * dx + dz * dz <= extended * extended && std::abs(dy) <= verticalRadius + extension;
+}
+
+/*
+* Run one frame of the engine without drawing. Chunks are marked as meshed before updating the octree,
+* so it is updated without OpenGL - removing chunks and unused nodes works the same way as in the game.
+*/
+static void runFrame(WorldStreamer* streamer, Octree* octree, const Region& region, const Vector3& position, const Vector3& direction,
+					 FrameStats* stats)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	streamer->Update(position, direction);
+	octree->UpdateTree();
+	std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start;
+
+	for (int z = region.low[2]; z <= region.high[2]; ++z) {
+		for (int y = region.low[1]; y <= region.high[1]; ++y) {
+			for (int x = region.low[0]; x <= region.high[0]; ++x) {
+				Chunk* chunk = octree->GetChunkAt(Vector3((x + 0.5f) * Chunk::dimension, (y + 0.5f) * Chunk::dimension, (z + 0.5f) * Chunk::dimension));
+				if (chunk != nullptr)
+					chunk->Validate();
+			}
+		}
+	}
+
+	start = std::chrono::high_resolution_clock::now();
+	octree->Update();
+	time += std::chrono::high_resolution_clock::now() - start;
+
+	++stats->frames;
+	stats->seconds += time.count();
+	stats->maxSeconds = std::max(stats->maxSeconds, time.count());
+}
+
+/* Run frames without moving until all chunks are generated and all far chunks are removed */
+static bool settle(WorldStreamer* streamer, Octree* octree, const Region& region, const Vector3& position, const Vector3& direction,
+				   bool threads, FrameStats* stats)
+{
+	size_t resident = streamer->GetResidentCount();
+	for (int frame = 0; frame < maxSettleFrames; ++frame) {
+		runFrame(streamer, octree, region, position, direction, stats);
+
+		/* Far chunks are removed every frame until none is left, so the count stops changing only when all are removed */
+		if (streamer->GetPendingCount() == 0 && streamer->GetResidentCount() == resident)
+			return true;
+		resident = streamer->GetResidentCount();
+
+		if (threads)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return false;
+}
+
+/* Dig the first solid voxel below the start and place a voxel in the first empty chunk above it, like the player does */
+static bool makeEdits(WorldStreamer* streamer, Octree* octree, std::vector<Edit>* edits, std::ostream& log)
+{
+	const float dim = (float)Chunk::dimension;
+	Vector3 start = getPathPoint(0);
+	float x = std::floor(start.x) + 3.0f;
+	float z = std::floor(start.z) + 3.0f;
+	float top = (std::floor(start.y / dim) + verticalRadius + 1) * dim - 1.0f;
+	float bottom = (std::floor(start.y / dim) - verticalRadius) * dim;
+
+	Vector3 dig;
+	bool found = false;
+	for (float y = top; y >= bottom && !found; y -= 1.0f) {
+		dig = Vector3(x, y, z);
+		found = !octree->GetVoxel(dig).IsEmpty();
+	}
+	if (!found) {
+		log << "No solid voxel to dig below the start\n";
+		return false;
+	}
+
+	Chunk* chunk = octree->GetChunkAt(dig);
+	chunk->Set(dig, Voxel::NONE);
+	chunk->MarkEdited();
+	edits->push_back({ dig, (unsigned char)Voxel::NONE });
+
+	for (Vector3 place = dig + Vector3(0.0f, dim, 0.0f); place.y <= top; place.y += dim) {
+		if (streamer->IsResident(place) && octree->GetChunkAt(place) == nullptr) {
+			octree->Insert(Voxel(Voxel::STONE), place);
+			edits->push_back({ place, (unsigned char)Voxel::STONE });
+			return true;
+		}
+	}
+
+	log << "No empty chunk to place voxel above the start\n";
+	return false;
+}
+
+/* Compare chunks found through the map of the octree with the ones found by walking down the tree */
+static bool checkChunkMap(Octree* octree, const Region& region, std::ostream& log)
+{
+	bool same = true;
+	for (int z = region.low[2]; z <= region.high[2]; ++z) {
+		for (int y = region.low[1]; y <= region.high[1]; ++y) {
+			for (int x = region.low[0]; x <= region.high[0]; ++x) {
+				Vector3 center = Vector3((float)x, (float)y, (float)z) * (float)Chunk::dimension + (float)Chunk::dimension / 2.0f;
+				if (octree->GetChunkAt(center) != octree->FindChunk(center)) {
+					log << "  chunk (" << x << ", " << y << ", " << z << ") is found differently through the map and the tree\n";
+					same = false;
+				}
+			}
+		}
+	}
+	return same;
+}
+
+/* Compare resident chunks and chunks stored in the octree with the ones expected around the position */
+static bool checkWorld(const WorldStreamer& streamer, Octree* octree, const TerrainGenerator& terrainGen, const Region& region,
+					   const Vector3& position, const std::vector<Edit>& edits, std::ostream& log)
+{
+	bool same = true;
+	size_t resident = 0;
+	size_t stored = 0;
+
+	for (int z = region.low[2]; z <= region.high[2]; ++z) {
+		for (int y = region.low[1]; y <= region.high[1]; ++y) {
+			for (int x = region.low[0]; x <= region.high[0]; ++x) {
+				Vector3 offset((float)(x * Chunk::dimension), (float)(y * Chunk::dimension), (float)(z * Chunk::dimension));
+				Vector3 center = offset + (float)Chunk::dimension / 2.0f;
+				bool isResident = streamer.IsResident(center);
+				Chunk* chunk = octree->GetChunkAt(center);
+				bool edited = chunk != nullptr && chunk->IsEdited();
+
+				resident += isResident ? 1 : 0;
+				stored += chunk != nullptr ? 1 : 0;
+
+				const char* error = nullptr;
+				if (!isResident && isInside(x, y, z, position, 0))
+					error = "is not resident within the radius";
+				else if (isResident && !edited && !isInside(x, y, z, position, hysteresis))
+					error = "is resident behind the hysteresis";
+				else if (!isResident && chunk != nullptr)
+					error = "is stored in the octree, but it is not resident";
+				else if (isResident && !edited) {
+					Chunk generated(offset);
+					bool filled = terrainGen.GetChunk(&generated);
+					if (filled != (chunk != nullptr))
+						error = filled ? "is missing in the octree" : "is empty, but it is stored in the octree";
+					else if (filled && generated.GetContentHash() != chunk->GetContentHash())
+						error = "has different voxels than generated one";
+				}
+
+				if (error != nullptr) {
+					log << "  chunk (" << x << ", " << y << ", " << z << ") " << error << "\n";
+					same = false;
+				}
+			}
+		}
+	}
+
+	same = checkChunkMap(octree, region, log) && same;
+
+	if (resident != streamer.GetResidentCount()) {
+		log << "  " << streamer.GetResidentCount() - resident << " resident chunks are outside of the path\n";
+		same = false;
+	}
+	if (stored != octree->GetChunksCount()) {
+		log << "  " << octree->GetChunksCount() - stored << " chunks are left in the octree outside of the path\n";
+		same = false;
+	}
+
+	for (size_t i = 0; i < edits.size(); ++i) {
+		if (octree->GetVoxel(edits[i].coordinates).GetType() != edits[i].type) {
+			log << "  edit at " << edits[i].coordinates.ToString() << " is lost\n";
+			same = false;
+		}
+	}
+
+	return same;
+}
+
+/*
+* Load the world around the start of the path with given number of streaming threads and compare it with chunks
+* generated one by one. Chunks must be the same for any number of threads. Time of loading is returned.
+*/
+static double loadWorld(int threads, size_t* chunks, bool* same, std::ostream& log)
+{
+	TerrainGenerator terrainGen;
+	makeGenerator(&terrainGen);
+
+	/* Streamer is declared later, so it is stopped before the octree is destroyed */
+	Octree octree;
+	WorldStreamer streamer;
+	streamer.SetGenerator(&terrainGen);
+	streamer.SetOctree(&octree);
+	streamer.SetRadius(loadRadius, loadVerticalRadius);
+	streamer.Start(threads);
+	/* Limit is used only by updates, loading must still use all threads */
+	streamer.SetMaxWorkingThreads(1);
+
+	Vector3 position = getPathPoint(0);
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	streamer.Load(position);
+	std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start;
+	streamer.Stop();
+	octree.UpdateTree();
+
+	TerrainGenerator reference;
+	makeGenerator(&reference);
+	Vector3 startChunk(std::floor(path[0][0]), std::floor(path[0][1]), std::floor(path[0][2]));
+	int different = 0;
+	for (int z = -loadRadius; z <= loadRadius; ++z) {
+		for (int y = -loadVerticalRadius; y <= loadVerticalRadius; ++y) {
+			for (int x = -loadRadius; x <= loadRadius; ++x) {
+				Vector3 offset = (startChunk + Vector3((float)x, (float)y, (float)z)) * (float)Chunk::dimension;
+				Vector3 center = offset + (float)Chunk::dimension / 2.0f;
+				Chunk* chunk = octree.GetChunkAt(center);
+
+				Chunk generated(offset);
+				bool inside = x * x + z * z <= loadRadius * loadRadius;
+				bool filled = inside && reference.GetChunk(&generated);
+				if (streamer.IsResident(center) != inside || filled != (chunk != nullptr)
+					|| (filled && generated.GetContentHash() != chunk->GetContentHash()))
+					++different;
+			}
+		}
+	}
+
+	if (different > 0) {
+		log << "  " << different << " chunks loaded with " << threads << " threads are different than generated ones\n";
+		*same = false;
+	}
+
+	*chunks = streamer.GetResidentCount();
+	return time.count();
+}
+
+/* Travel along the path with given number of streaming threads, world is checked at each point of the path */
+static bool runPath(int threads, bool csv, std::ostream& log)
+{
+	TerrainGenerator terrainGen;
+	makeGenerator(&terrainGen);
+	const Region region = getRegion();
+
+	/* Streamer is declared later, so it is stopped before the octree is destroyed */
+	Octree octree;
+	WorldStreamer streamer;
+	streamer.SetGenerator(&terrainGen);
+	streamer.SetOctree(&octree);
+	streamer.SetRadius(radius, verticalRadius);
+	streamer.SetHysteresis(hysteresis);
+
+	FrameStats stats = { 0, 0.0, 0.0 };
+	std::vector<Edit> edits;
+	bool same = true;
+
+	Vector3 position = getPathPoint(0);
+	Vector3 direction = Vector3::forward;
+	streamer.Load(position);
+	streamer.Start(threads);
+	same = settle(&streamer, &octree, region, position, direction, threads > 0, &stats) && same;
+	same = checkChunkMap(&octree, region, log) && same;
+	same = makeEdits(&streamer, &octree, &edits, log) && same;
+
+	for (int i = 0; i < pathPoints; ++i) {
+		Vector3 from = position;
+		Vector3 target = getPathPoint(i);
+		Vector3 move = target - from;
+		int steps = (int)std::ceil(move.Magnitude() / stepLength);
+		if (steps > 0)
+			direction = Vector3::Normalized(move);
+
+		for (int step = 1; step <= steps; ++step) {
+			position = from + move * ((float)step / steps);
+			runFrame(&streamer, &octree, region, position, direction, &stats);
+		}
+		position = target;
+
+		if (!settle(&streamer, &octree, region, position, direction, threads > 0, &stats)) {
+			log << "  streamer did not finish loading at point " << i << " of the path\n";
+			same = false;
+		}
+		if (!checkWorld(streamer, &octree, terrainGen, region, position, edits, log)) {
+			log << "  world is different at point " << i << " of the path\n";
+			same = false;
+		}
+	}
+
+	streamer.Stop();
+
+	if (csv)
+		std::cout << threads << "," << stats.frames << "," << stats.seconds << "," << 1000.0 * stats.seconds / stats.frames << ","
+				  << 1000.0 * stats.maxSeconds << "\n";
+	else
+		std::cout << "  " << threads << " threads: " << stats.frames << " frames, " << stats.seconds << " s, "
+				  << 1000.0 * stats.seconds / stats.frames << " ms per frame, the longest " << 1000.0 * stats.maxSeconds << " ms\n";
+
+	return same;
+}
+
+int runWorldBenchmark(bool csv)
+{
+	std::ostream& log = csv ? std::cerr : std::cout;
+	bool same = true;
+
+	log << "World benchmark, radius " << radius << " and " << verticalRadius << " chunks of dimension " << Chunk::dimension
+		<< ", " << pathPoints << " points of the path\n";
+	/* Calling thread is loading chunks too, so the number of generating threads is one more */
+	std::vector<int> threadCounts = { 0, 1, 3 };
+	int cores = (int)std::thread::hardware_concurrency();
+	if (cores > 4)
+		threadCounts.push_back(cores - 1);
+
+	if (csv)
+		std::cout << "loadThreads,seconds,chunksPerSecond\n";
+	double single = 0.0;
+	for (size_t i = 0; i < threadCounts.size(); ++i) {
+		size_t chunks = 0;
+		double time = loadWorld(threadCounts[i], &chunks, &same, log);
+		if (i == 0)
+			single = time;
+
+		if (csv)
+			std::cout << threadCounts[i] + 1 << "," << time << "," << chunks / time << "\n";
+		else
+			std::cout << "  load with " << threadCounts[i] + 1 << " threads: " << time << " s (x" << single / time << "), "
+					  << chunks / time << " chunks/s\n";
+	}
+
+	if (csv)
+		std::cout << "threads,frames,seconds,msPerFrame,maxMsPerFrame\n";
+
+	/* Without threads chunks are generated during updates, which is deterministic */
+	same = runPath(0, csv, log) && same;
+	same = runPath(2, csv, log) && same;
+
+	log << "World streaming " << (same ? "OK" : "FAILED") << "\n";
+	return same ? 0 : VE_FAULT;
+}
+
+}
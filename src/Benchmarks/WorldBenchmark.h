@@ -0,0 +1,16 @@
+#pragma once
+
+namespace vengine {
+
+/*
+* Drive the world streamer along a scripted path of the player without window, once with chunks generated during
+* updates and once with background threads. After every part of the path resident chunks must be exactly the ones
+* within the radius, extended by the hysteresis for chunks loaded earlier. Every resident chunk must be stored
+* in the octree with the generated voxels and nothing else may be left in the octree. The map of the octree must
+* find the same chunks as walking down the tree. Chunks edited by the player must keep their edits while the player
+* is away and come back. Time of the updates is reported. World around the start is also loaded at once with different
+* numbers of threads, chunks must be the same as generated one by one and time of loading is reported.
+*/
+int runWorldBenchmark(bool csv = false);
+
+}
@@ -0,0 +1,103 @@
+#include "ChunkMap.h"
+#include "Resources/Voxels/Chunk.h"
+
+#include <cmath>
+
+namespace vengine {
+
+ChunkMap::ChunkMap()
+{
+	_mask = 0;
+	_size = 0;
+}
+
+ChunkMap::Key
+ChunkMap::GetKey(const Vector3& position)
+{
+	Key key;
+	key.x = (int)std::floor(position.x / Chunk::dimension);
+	key.y = (int)std::floor(position.y / Chunk::dimension);
+	key.z = (int)std::floor(position.z / Chunk::dimension);
+	return key;
+}
+
+void
+ChunkMap::Insert(const Key& key, Octree* node)
+{
+	assert(node != nullptr, "Cannot store null node in the chunk map.");
+
+	/* Keep at least half of the slots empty, so probe sequences stay short */
+	if (2 * (_size + 1) > _slots.size())
+		Grow();
+
+	size_t i = GetHome(key);
+	for (; _slots[i].node != nullptr; i = (i + 1) & _mask) {
+		if (_slots[i].key == key) {
+			_slots[i].node = node;
+			return;
+		}
+	}
+
+	_slots[i].key = key;
+	_slots[i].node = node;
+	++_size;
+}
+
+bool
+ChunkMap::Remove(const Key& key)
+{
+	if (_size == 0)
+		return false;
+
+	size_t hole = GetHome(key);
+	for (; _slots[hole].node != nullptr; hole = (hole + 1) & _mask)
+		if (_slots[hole].key == key)
+			break;
+
+	if (_slots[hole].node == nullptr)
+		return false;
+
+	/*
+	* Following keys of the probe sequence are shifted back into the hole, unless their home slot lies between the hole
+	* and their current slot - then they would not be found from their home anymore
+	*/
+	for (size_t i = (hole + 1) & _mask; _slots[i].node != nullptr; i = (i + 1) & _mask) {
+		size_t home = GetHome(_slots[i].key);
+		if (((i - home) & _mask) >= ((i - hole) & _mask)) {
+			_slots[hole] = _slots[i];
+			hole = i;
+		}
+	}
+
+	_slots[hole].node = nullptr;
+	--_size;
+	return true;
+}
+
+void
+ChunkMap::Clear()
+{
+	std::vector<Slot>().swap(_slots);
+	_mask = 0;
+	_size = 0;
+}
+
+void
+ChunkMap::Grow()
+{
+	std::vector<Slot> slots(_slots.empty() ? _minimumCapacity : 2 * _slots.size(), Slot{ { 0, 0, 0 }, nullptr });
+	slots.swap(_slots);
+	_mask = _slots.size() - 1;
+
+	for (size_t i = 0; i < slots.size(); ++i) {
+		if (slots[i].node == nullptr)
+			continue;
+
+		size_t j = GetHome(slots[i].key);
+		while (_slots[j].node != nullptr)
+			j = (j + 1) & _mask;
+		_slots[j] = slots[i];
+	}
+}
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Math/Vector3.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace vengine {
+
+class Octree;
+
+/*
+* Hash map from the integer coordinates of the chunks to the smallest leaves of the octree holding them.
+* It uses open addressing with linear probing in one array, so a lookup is one hash and usually one or two comparisons,
+* without walking down the tree. Removed keys are filled by shifting the following keys back instead of leaving
+* tombstones, so lookups do not slow down while chunks are streamed in and out. Capacity is a power of two
+* and the array grows twice when it becomes half full.
+*/
+class ChunkMap {
+public:
+	/* Coordinates of the chunk, which is the offset of the chunk divided by chunk dimension */
+	struct Key {
+		int x;
+		int y;
+		int z;
+
+		bool operator==(const Key& other) const;
+	};
+
+	ChunkMap();
+
+	/* Get key of the chunk containing given point */
+	static Key GetKey(const Vector3& position);
+
+	/* Get node stored for the key or nullptr if there is none */
+	Octree* Find(const Key& key) const;
+	/* Store node for the key, replacing previous one */
+	void Insert(const Key& key, Octree* node);
+	/* Remove node stored for the key. Returns false if there is none. */
+	bool Remove(const Key& key);
+	/* Remove all nodes and release memory */
+	void Clear();
+
+	/* Get number of stored nodes */
+	size_t GetSize() const;
+
+private:
+	/* Slot is empty when node is nullptr */
+	struct Slot {
+		Key key;
+		Octree* node;
+	};
+
+	std::vector<Slot> _slots;
+	size_t _mask;	/* Number of slots minus one */
+	size_t _size;
+
+	static const size_t _minimumCapacity = 64;
+
+	/* Get slot where probing for the key starts */
+	size_t GetHome(const Key& key) const;
+	/* Double the number of slots and insert all nodes again */
+	void Grow();
+
+	static size_t Hash(const Key& key);
+};
+
+inline bool
+ChunkMap::Key::operator==(const Key& other) const
+{
+	return x == other.x && y == other.y && z == other.z;
+}
+
+inline size_t
+ChunkMap::Hash(const Key& key)
+{
+	/* Neighbouring chunks differ in low bits only, so coordinates are multiplied by large odd numbers and high bits are folded back */
+	uint64_t hash = (uint64_t)(uint32_t)key.x * 0x9E3779B97F4A7C15ull ^
+					(uint64_t)(uint32_t)key.y * 0xC2B2AE3D27D4EB4Full ^
+					(uint64_t)(uint32_t)key.z * 0x165667B19E3779F9ull;
+	return (size_t)(hash ^ (hash >> 32));
+}
+
+inline size_t
+ChunkMap::GetHome(const Key& key) const
+{
+	return Hash(key) & _mask;
+}
+
+inline Octree*
+ChunkMap::Find(const Key& key) const
+{
+	if (_size == 0)
+		return nullptr;
+
+	/* Map is never full, so probing always ends at an empty slot */
+	for (size_t i = GetHome(key); _slots[i].node != nullptr; i = (i + 1) & _mask)
+		if (_slots[i].key == key)
+			return _slots[i].node;
+
+	return nullptr;
+}
+
+inline size_t
+ChunkMap::GetSize() const
+{
+	return _size;
+}
+
+}
@@ -0,0 +1,110 @@
+#include "HeightMapCache.h"
+
+namespace vengine {
+
+void
+HeightMapCache::HeightMap::UpdateRange()
+{
+	minHeight = heights[0];
+	maxHeight = heights[0];
+	for (int i = 1; i < Chunk::dimension * Chunk::dimension; ++i) {
+		if (heights[i] < minHeight)
+			minHeight = heights[i];
+		if (heights[i] > maxHeight)
+			maxHeight = heights[i];
+	}
+}
+
+HeightMapCache::HeightMapCache(size_t maxColumns) : _maxColumns(maxColumns)
+{
+	_stats.hits = 0;
+	_stats.misses = 0;
+	_stats.evictions = 0;
+}
+
+bool
+HeightMapCache::Find(int x, int z, HeightMap* heightMap)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Key key = { x, z };
+	std::unordered_map<Key, Entry, KeyHash>::iterator it = _entries.find(key);
+	if (it == _entries.end()) {
+		++_stats.misses;
+		return false;
+	}
+
+	++_stats.hits;
+	_usage.splice(_usage.end(), _usage, it->second.usage);
+	*heightMap = it->second.heightMap;
+	return true;
+}
+
+void
+HeightMapCache::Insert(int x, int z, const HeightMap& heightMap)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_maxColumns == 0)
+		return;
+
+	/* Other thread could compute the same column in the meantime, heights are the same anyway */
+	Key key = { x, z };
+	if (_entries.find(key) != _entries.end())
+		return;
+
+	Entry& entry = _entries[key];
+	entry.heightMap = heightMap;
+	entry.usage = _usage.insert(_usage.end(), key);
+	Evict();
+}
+
+void
+HeightMapCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_entries.clear();
+	_usage.clear();
+}
+
+void
+HeightMapCache::SetMaxColumns(size_t maxColumns)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_maxColumns = maxColumns;
+	Evict();
+}
+
+HeightMapCache::Stats
+HeightMapCache::GetStats()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _stats;
+}
+
+double
+HeightMapCache::GetHitRate()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	uint64_t lookups = _stats.hits + _stats.misses;
+	return lookups > 0 ? (double)_stats.hits / lookups : 0.0;
+}
+
+size_t
+HeightMapCache::GetSize()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _entries.size();
+}
+
+void
+HeightMapCache::Evict()
+{
+	while (_usage.size() > _maxColumns) {
+		_entries.erase(_usage.front());
+		_usage.pop_front();
+		++_stats.evictions;
+	}
+}
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Resources/Voxels/Chunk.h"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace vengine {
+
+/*
+* Cache of the terrain heights of the chunk columns, keyed by the position of the column.
+* All chunks stacked on the same column share one height map, so noise is computed only for the first of them.
+* Columns are evicted starting with the least recently used. All methods are thread safe, so chunks can be generated
+* from many threads at once. Height maps are copied in and out, so evicted column is never used by another thread.
+*/
+class HeightMapCache {
+public:
+	/* Heights of the terrain in one chunk column */
+	struct HeightMap {
+		int heights[Chunk::dimension * Chunk::dimension];	/* Height of the point (x, z) is at index x + dimension * z */
+		int minHeight;	/* Lowest height in the column */
+		int maxHeight;	/* Highest height in the column */
+
+		/* Update minHeight and maxHeight from the heights */
+		void UpdateRange();
+	};
+
+	/* Counters of the lookups */
+	struct Stats {
+		uint64_t hits;		/* Lookups which found height map */
+		uint64_t misses;	/* Lookups which did not found height map, so it had to be computed */
+		uint64_t evictions;	/* Height maps deleted because of the limit */
+	};
+
+	/* Height maps above given limit are deleted, starting with the least recently used. With 0 nothing is stored. */
+	HeightMapCache(size_t maxColumns = 1024);
+
+	/* Copy height map of the column starting at given world coordinates, returns false if there is none */
+	bool Find(int x, int z, HeightMap* heightMap);
+	/* Store height map of the column starting at given world coordinates, it is ignored if column is already stored */
+	void Insert(int x, int z, const HeightMap& heightMap);
+	/* Delete all height maps, for example after terrain settings were changed. Stats are kept. */
+	void Clear();
+
+	/* Set limit of the stored height maps, least recently used are deleted if there are more of them */
+	void SetMaxColumns(size_t maxColumns);
+
+	Stats GetStats();
+	/* Get part of the lookups which found height map */
+	double GetHitRate();
+	/* Get number of stored height maps */
+	size_t GetSize();
+
+private:
+	struct Key {
+		int x;
+		int z;
+
+		bool operator==(const Key& other) const;
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key& key) const;
+	};
+
+	typedef std::list<Key> UsageList;
+
+	struct Entry {
+		HeightMap heightMap;
+		UsageList::iterator usage;	/* Position in the usage list */
+	};
+
+	std::mutex _mutex;
+	std::unordered_map<Key, Entry, KeyHash> _entries;
+	UsageList _usage;	/* Keys of the stored columns, the most recently used is at the back */
+	size_t _maxColumns;
+	Stats _stats;
+
+	/* Delete least recently used columns above the limit. Mutex must be locked. */
+	void Evict();
+};
+
+inline bool
+HeightMapCache::Key::operator==(const Key& other) const
+{
+	return x == other.x && z == other.z;
+}
+
+inline size_t
+HeightMapCache::KeyHash::operator()(const Key& key) const
+{
+	return (size_t)hashCombine((uint64_t)(int64_t)key.x, (uint64_t)(int64_t)key.z);
+}
+
+}
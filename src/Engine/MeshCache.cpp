@@ -0,0 +1,107 @@
+#include "MeshCache.h"
+
+namespace vengine {
+
+MeshCache::MeshCache(size_t maxUnused) : _maxUnused(maxUnused)
+{
+	_stats.hits = 0;
+	_stats.misses = 0;
+	_stats.evictions = 0;
+}
+
+MeshCache::~MeshCache()
+{
+	Clear();
+}
+
+MeshCache::Key
+MeshCache::GetKey(const Chunk& chunk, const Chunk::Border& border)
+{
+	Key key;
+	key.voxels = chunk.GetContentHash();
+	key.border = border.GetHash();
+	key.solid = chunk.GetSolidCount();
+	key.voxelSize = chunk.GetVoxelSize();
+	return key;
+}
+
+VoxelMesh*
+MeshCache::Acquire(const Key& key)
+{
+	std::unordered_map<Key, Entry, KeyHash>::iterator it = _entries.find(key);
+	if (it == _entries.end()) {
+		++_stats.misses;
+		return nullptr;
+	}
+
+	++_stats.hits;
+	Entry& entry = it->second;
+	if (entry.references++ == 0)
+		_unused.erase(entry.unused);
+
+	return entry.mesh;
+}
+
+bool
+MeshCache::Insert(const Key& key, VoxelMesh* mesh)
+{
+	assert(!Contains(mesh), "Mesh is already stored in the cache.");
+
+	Entry entry;
+	entry.mesh = mesh;
+	entry.references = 1;
+	if (!_entries.insert(std::make_pair(key, entry)).second)
+		return false;
+
+	_keys.insert(std::make_pair(mesh, key));
+	return true;
+}
+
+void
+MeshCache::Release(VoxelMesh* mesh)
+{
+	std::unordered_map<const VoxelMesh*, Key>::iterator keyIt = _keys.find(mesh);
+	assert(keyIt != _keys.end(), "Mesh is not stored in the cache.");
+
+	Entry& entry = _entries.find(keyIt->second)->second;
+	assert(entry.references > 0, "Mesh has no references.");
+	if (--entry.references > 0)
+		return;
+
+	entry.unused = _unused.insert(_unused.end(), keyIt->second);
+	while (_unused.size() > _maxUnused) {
+		Remove(_entries.find(_unused.front()));
+		++_stats.evictions;
+	}
+}
+
+void
+MeshCache::Clear()
+{
+	for (std::unordered_map<Key, Entry, KeyHash>::iterator it = _entries.begin(); it != _entries.end(); ++it)
+		delete it->second.mesh;
+
+	_entries.clear();
+	_keys.clear();
+	_unused.clear();
+}
+
+double
+MeshCache::GetHitRate() const
+{
+	uint64_t lookups = _stats.hits + _stats.misses;
+	return lookups > 0 ? (double)_stats.hits / lookups : 0.0;
+}
+
+void
+MeshCache::Remove(std::unordered_map<Key, Entry, KeyHash>::iterator it)
+{
+	if (it->second.references == 0)
+		_unused.erase(it->second.unused);
+
+	_keys.erase(it->second.mesh);
+	delete it->second.mesh;
+	_entries.erase(it);
+}
+
+}
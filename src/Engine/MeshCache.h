@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Resources/Voxels/Chunk.h"
+
+#include <list>
+#include <unordered_map>
+
+namespace vengine {
+
+/*
+* Cache of the chunk meshes keyed by the hash of the voxels, border of the neighbours and voxel size.
+* Number of solid voxels is compared as well, so colliding hashes of different chunks are very unlikely to share mesh.
+* Chunks with the same contents, like solid interiors or repeated structures, are drawing one shared mesh,
+* so its vertices are generated and uploaded only once. Shared meshes are counted with references.
+* Meshes which are not used by any chunk are kept for a while, so chunk restored to the previous state
+* (like after placing and digging a voxel) gets its old mesh back. Cached meshes are never modified,
+* chunk changing its mesh releases the cached one and draws a copy.
+*/
+class MeshCache {
+public:
+	/* Contents of the chunk which mesh depends on */
+	struct Key {
+		uint64_t voxels;	/* Hash of the voxel types */
+		uint64_t border;	/* Hash of the border of the neighbours */
+		int solid;			/* Number of solid voxels */
+		float voxelSize;
+
+		bool operator==(const Key& other) const;
+	};
+
+	/* Counters of the lookups, used to judge if cache is worth it for the world */
+	struct Stats {
+		uint64_t hits;		/* Lookups which found mesh */
+		uint64_t misses;	/* Lookups which did not found mesh, so it had to be generated */
+		uint64_t evictions;	/* Unused meshes deleted because of the limit */
+	};
+
+	/* Unused meshes above given limit are deleted, starting with the least recently used */
+	MeshCache(size_t maxUnused = 256);
+	/* Deletes all meshes, they must not be used anymore */
+	~MeshCache();
+
+	/* Get key of the chunk with given border */
+	static Key GetKey(const Chunk& chunk, const Chunk::Border& border);
+
+	/* Get mesh stored for the key and add reference to it, returns nullptr if there is none */
+	VoxelMesh* Acquire(const Key& key);
+	/* Store generated mesh for the key, cache takes ownership and caller holds one reference. Returns false if key is already stored. */
+	bool Insert(const Key& key, VoxelMesh* mesh);
+	/* Remove reference to the mesh got with Acquire or given to Insert */
+	void Release(VoxelMesh* mesh);
+	/* Check if mesh is owned by the cache */
+	bool Contains(const VoxelMesh* mesh) const;
+	/* Delete all meshes */
+	void Clear();
+
+	const Stats& GetStats() const;
+	/* Get part of the lookups which found mesh */
+	double GetHitRate() const;
+	/* Get number of stored meshes, used and unused */
+	size_t GetSize() const;
+
+private:
+	struct KeyHash {
+		size_t operator()(const Key& key) const;
+	};
+
+	typedef std::list<Key> UnusedList;
+
+	struct Entry {
+		VoxelMesh* mesh;
+		int references;
+		UnusedList::iterator unused;	/* Position in the list of unused meshes, valid only without references */
+	};
+
+	std::unordered_map<Key, Entry, KeyHash> _entries;
+	std::unordered_map<const VoxelMesh*, Key> _keys;	/* Keys of the stored meshes */
+	UnusedList _unused;		/* Keys of the meshes without references, the most recently released is at the back */
+	size_t _maxUnused;
+	Stats _stats;
+
+	/* Remove entry and delete its mesh */
+	void Remove(std::unordered_map<Key, Entry, KeyHash>::iterator it);
+};
+
+inline bool
+MeshCache::Key::operator==(const Key& other) const
+{
+	return voxels == other.voxels && border == other.border && solid == other.solid && voxelSize == other.voxelSize;
+}
+
+inline size_t
+MeshCache::KeyHash::operator()(const Key& key) const
+{
+	return (size_t)(key.voxels ^ (key.border * 31));
+}
+
+inline bool
+MeshCache::Contains(const VoxelMesh* mesh) const
+{
+	return _keys.find(mesh) != _keys.end();
+}
+
+inline const MeshCache::Stats&
+MeshCache::GetStats() const
+{
+	return _stats;
+}
+
+inline size_t
+MeshCache::GetSize() const
+{
+	return _entries.size();
+}
+
+}
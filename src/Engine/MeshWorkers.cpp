@@ -0,0 +1,270 @@
+#include "MeshWorkers.h"
+
+#include <algorithm>
+
+namespace vengine {
+
+MeshWorkers::MeshWorkers() : _nextRevision(0), _working(0), _maxUploads(8), _stop(false)
+{
+}
+
+MeshWorkers::~MeshWorkers()
+{
+	Stop();
+
+	for (size_t i = 0; i < _freeCopies.size(); ++i)
+		delete _freeCopies[i];
+	for (size_t i = 0; i < _freeMeshes.size(); ++i)
+		delete _freeMeshes[i];
+	for (size_t i = 0; i < _finished.size(); ++i)
+		delete _finished[i].result.mesh;
+	for (size_t i = 0; i < _takenMeshes.size(); ++i)
+		delete _takenMeshes[i];
+}
+
+void
+MeshWorkers::Start(int threadsNumber)
+{
+	assert(_threads.empty(), "Mesh workers are already started.");
+
+	for (int i = 0; i < threadsNumber; ++i)
+		_threads.push_back(std::thread(&MeshWorkers::Work, this));
+}
+
+void
+MeshWorkers::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_jobReady.notify_all();
+
+	for (size_t i = 0; i < _threads.size(); ++i)
+		_threads[i].join();
+	_threads.clear();
+
+	/* Chunks of dropped jobs must not stay pending, otherwise they would never be patched or cached again */
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (size_t i = 0; i < _jobs.size(); ++i) {
+		_freeCopies.push_back(_jobs[i].copy);
+		_revisions.erase(_jobs[i].chunk);
+	}
+	_jobs.clear();
+	_stop = false;
+}
+
+void
+MeshWorkers::Schedule(Chunk* chunk, const Chunk::Border& border)
+{
+	Job job;
+	job.border = border;
+	job.lod = 0;
+	Push(job, chunk);
+}
+
+void
+MeshWorkers::ScheduleLod(Chunk* chunk, int lod)
+{
+	assert(lod > 0 && lod <= Chunk::lodLevels, "Wrong level of detail: %d.", lod);
+
+	Job job;
+	job.lod = lod;
+	Push(job, chunk);
+}
+
+void
+MeshWorkers::Push(Job& job, Chunk* chunk)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	job.chunk = chunk;
+	job.revision = ++_nextRevision;
+
+	/* Results finished before the chunk was scheduled for the first time belong to the deleted chunk with the same address */
+	std::unordered_map<Chunk*, Revisions>::iterator it = _revisions.find(chunk);
+	if (it == _revisions.end()) {
+		Revisions revisions;
+		for (int lod = 0; lod <= Chunk::lodLevels; ++lod) {
+			revisions.scheduled[lod] = 0;
+			revisions.taken[lod] = job.revision - 1;
+		}
+		it = _revisions.insert(std::make_pair(chunk, revisions)).first;
+	}
+	it->second.scheduled[job.lod] = job.revision;
+
+	job.copy = nullptr;
+	if (!_freeCopies.empty()) {
+		job.copy = _freeCopies.back();
+		_freeCopies.pop_back();
+	}
+
+	/* Workers finishing their jobs and Pop are not waiting for the copy, chunk is edited only on this thread */
+	lock.unlock();
+	if (job.copy == nullptr)
+		job.copy = new Chunk(*chunk);
+	else
+		*job.copy = *chunk;
+	lock.lock();
+
+	if (_threads.empty()) {
+		Process(job, lock);
+		return;
+	}
+
+	_jobs.push_back(job);
+	lock.unlock();
+	_jobReady.notify_one();
+}
+
+void
+MeshWorkers::Cancel(Chunk* chunk)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	/* Jobs being processed right now will be dropped in Pop, as there will be no revision for them */
+	_revisions.erase(chunk);
+
+	for (std::deque<Job>::iterator it = _jobs.begin(); it != _jobs.end();) {
+		if (it->chunk == chunk) {
+			_freeCopies.push_back(it->copy);
+			it = _jobs.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	for (std::deque<Finished>::iterator it = _finished.begin(); it != _finished.end();) {
+		if (it->result.chunk == chunk) {
+			it->result.mesh->ClearVertices();
+			_freeMeshes.push_back(it->result.mesh);
+			it = _finished.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+bool
+MeshWorkers::IsPending(Chunk* chunk)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	std::unordered_map<Chunk*, Revisions>::const_iterator it = _revisions.find(chunk);
+	return it != _revisions.end() && it->second.scheduled[0] > it->second.taken[0];
+}
+
+void
+MeshWorkers::Wait()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_jobDone.wait(lock, [this] { return _jobs.empty() && _working == 0; });
+}
+
+bool
+MeshWorkers::Pop(Result* result)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	while (!_finished.empty()) {
+		Finished finished = _finished.front();
+		_finished.pop_front();
+
+		/* Drop meshes of cancelled chunks and meshes older than the one already taken */
+		std::unordered_map<Chunk*, Revisions>::iterator it = _revisions.find(finished.result.chunk);
+		if (it == _revisions.end() || finished.revision <= it->second.taken[finished.result.lod]) {
+			finished.result.mesh->ClearVertices();
+			_freeMeshes.push_back(finished.result.mesh);
+			continue;
+		}
+
+		it->second.taken[finished.result.lod] = finished.revision;
+		_takenMeshes.push_back(finished.result.mesh);
+		*result = finished.result;
+		return true;
+	}
+
+	return false;
+}
+
+void
+MeshWorkers::Release(VoxelMesh* mesh)
+{
+	mesh->ClearVertices();
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	std::vector<VoxelMesh*>::iterator it = std::find(_takenMeshes.begin(), _takenMeshes.end(), mesh);
+	assert(it != _takenMeshes.end(), "Mesh was not taken from the workers.");
+	/* Only few meshes are taken at once, so order does not have to be kept */
+	*it = _takenMeshes.back();
+	_takenMeshes.pop_back();
+	_freeMeshes.push_back(mesh);
+}
+
+void
+MeshWorkers::Work()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (true) {
+		_jobReady.wait(lock, [this] { return _stop || !_jobs.empty(); });
+		if (_stop)
+			return;
+
+		Job job = _jobs.front();
+		_jobs.pop_front();
+
+		/* Newer copy of the chunk is waiting, so this mesh would be dropped anyway */
+		if (IsOutdated(job)) {
+			_freeCopies.push_back(job.copy);
+			_jobDone.notify_all();
+			continue;
+		}
+
+		Process(job, lock);
+		_jobDone.notify_all();
+	}
+}
+
+void
+MeshWorkers::Process(Job& job, std::unique_lock<std::mutex>& lock)
+{
+	VoxelMesh* mesh;
+	if (_freeMeshes.empty()) {
+		mesh = new VoxelMesh;
+	}
+	else {
+		mesh = _freeMeshes.back();
+		_freeMeshes.pop_back();
+	}
+
+	/* Copy and mesh are owned only by this job, so meshing does not need the lock */
+	++_working;
+	lock.unlock();
+	if (job.lod == 0)
+		job.copy->GenerateMesh(mesh, job.border);
+	else
+		job.copy->GenerateLodMesh(mesh, job.lod);
+	lock.lock();
+	--_working;
+
+	_freeCopies.push_back(job.copy);
+
+	Finished finished;
+	finished.result.chunk = job.chunk;
+	finished.result.lod = job.lod;
+	finished.result.mesh = mesh;
+	finished.revision = job.revision;
+	_finished.push_back(finished);
+}
+
+bool
+MeshWorkers::IsOutdated(const Job& job) const
+{
+	std::unordered_map<Chunk*, Revisions>::const_iterator it = _revisions.find(job.chunk);
+	return it == _revisions.end() || it->second.scheduled[job.lod] != job.revision;
+}
+
+}
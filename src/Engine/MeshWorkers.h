@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Resources/Voxels/Chunk.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace vengine {
+
+/*
+* Pool of threads generating meshes of the changed chunks in the background.
+* Chunk is copied together with its border when the job is scheduled, so it can be edited while the mesh is generated.
+* Finished vertices are taken by the main thread, which is the only one uploading them to OpenGL.
+* Chunk meshed for the first time has no vertices until its mesh is taken, so it is not drawn for a few frames.
+*
+* Jobs are numbered with increasing revisions. Pending job is skipped if newer one has been scheduled for the same chunk
+* and level of detail, and finished mesh older than the one already taken is dropped, so the chunk never goes back to the older mesh.
+* Without threads, jobs are done on the calling thread inside Schedule, which gives deterministic results.
+*/
+class MeshWorkers {
+public:
+	/* Finished mesh of the chunk */
+	struct Result {
+		Chunk* chunk;		/* Chunk given to Schedule */
+		int lod;			/* Level of detail of the mesh, 0 is full detail */
+		VoxelMesh* mesh;	/* Generated vertices, it must be given back with Release */
+	};
+
+	MeshWorkers();
+	/* Stops threads and deletes all copies and meshes, including the ones taken with Pop and not given back */
+	~MeshWorkers();
+
+	/* Start given number of threads. With 0 threads jobs are done immediately in Schedule. */
+	void Start(int threadsNumber);
+	/* Stop all threads after they finish current jobs. Pending jobs are dropped together with finished meshes of their chunks. */
+	void Stop();
+
+	/* Schedule generating mesh of the chunk with given border of the neighbours */
+	void Schedule(Chunk* chunk, const Chunk::Border& border);
+	/* Schedule generating coarse mesh of the chunk, lod must be in range [1, Chunk::lodLevels] */
+	void ScheduleLod(Chunk* chunk, int lod);
+	/* Drop all jobs and meshes of the chunk. It must be called before the chunk is deleted. */
+	void Cancel(Chunk* chunk);
+	/* Check if full detail mesh of the chunk has been scheduled, but not taken with Pop yet */
+	bool IsPending(Chunk* chunk);
+	/* Wait until all scheduled jobs are done */
+	void Wait();
+
+	/* Take next finished mesh, returns false if there is none. Mesh is owned by the workers until it is given back. */
+	bool Pop(Result* result);
+	/* Give back mesh taken with Pop, so its memory will be reused by the next job */
+	void Release(VoxelMesh* mesh);
+
+	/* Set how many finished meshes can be uploaded in one frame, so uploads are not stalling the frame */
+	void SetMaxUploadsPerFrame(int uploads);
+	int GetMaxUploadsPerFrame() const;
+
+	int GetThreadsNumber() const;
+
+private:
+	struct Job {
+		Chunk* chunk;			/* Chunk given to Schedule, used only as a key */
+		Chunk* copy;			/* Copy of the chunk, which is meshed */
+		Chunk::Border border;	/* Border of the neighbours at the time of scheduling, not used by coarse meshes */
+		int lod;
+		uint64_t revision;
+	};
+
+	struct Finished {
+		Result result;
+		uint64_t revision;
+	};
+
+	/* Revisions are kept separately for each level of detail */
+	struct Revisions {
+		uint64_t scheduled[Chunk::lodLevels + 1];	/* Revision of the newest scheduled job */
+		uint64_t taken[Chunk::lodLevels + 1];		/* Revision of the newest mesh taken with Pop */
+	};
+
+	std::vector<std::thread> _threads;
+	std::mutex _mutex;
+	std::condition_variable _jobReady;	/* Notified when new job is added or threads are stopping */
+	std::condition_variable _jobDone;	/* Notified when job is finished or skipped */
+
+	std::deque<Job> _jobs;			/* Pending jobs */
+	std::deque<Finished> _finished;	/* Meshes waiting for Pop */
+	std::unordered_map<Chunk*, Revisions> _revisions;
+
+	std::vector<Chunk*> _freeCopies;		/* Copies reused by next jobs, copying a chunk into them reuses their buffers when they are large enough */
+	std::vector<VoxelMesh*> _freeMeshes;	/* Meshes reused by next jobs */
+	std::vector<VoxelMesh*> _takenMeshes;	/* Meshes taken with Pop and not given back with Release yet */
+
+	uint64_t _nextRevision;
+	int _working;		/* Number of jobs being processed right now */
+	int _maxUploads;
+	bool _stop;
+
+	/* Copy the chunk and add job, which is done immediately if there are no threads */
+	void Push(Job& job, Chunk* chunk);
+	/* Thread routine */
+	void Work();
+	/* Generate mesh for the job and store it. Mutex must be locked, it is unlocked while meshing. */
+	void Process(Job& job, std::unique_lock<std::mutex>& lock);
+	/* Check if newer job has been scheduled for the same chunk or chunk was cancelled */
+	bool IsOutdated(const Job& job) const;
+};
+
+inline void
+MeshWorkers::SetMaxUploadsPerFrame(int uploads)
+{
+	_maxUploads = uploads;
+}
+
+inline int
+MeshWorkers::GetMaxUploadsPerFrame() const
+{
+	return _maxUploads;
+}
+
+inline int
+MeshWorkers::GetThreadsNumber() const
+{
+	return (int)_threads.size();
+}
+
+}
@@ -180,6 +180,7 @@ PlayerController::ChangeBlocks()
 				/* If we hit something, we want to delete things */
 				if (_rayInfo.CollisionFound()) {
 					hitCh->Set(coord, Voxel::NONE);
+					hitCh->MarkEdited();
 				}
 				break;
 			case DIRT:
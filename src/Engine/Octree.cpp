@@ -3,45 +3,53 @@
 namespace vengine {
 
 bool Octree::_built = false;
+MeshWorkers* Octree::_meshWorkers = nullptr;
+MeshCache* Octree::_meshCache = nullptr;
 
 Octree::Octree() :
-	_children{}, _area(Vector3::zeroes, Vector3::zeroes)
+	_children{}, _lodMeshes{}, _area(Vector3::zeroes, Vector3::zeroes)
 {
 	_timeToLive = -1;
 	_availableLifetime = _initialAvailableLifetime;
 	_chunkChildren = 0;
 	_physicChildren = 0;
 	_chunkMesh = nullptr;
+	_lodScheduled = 0;
+	_lod = 0;
 	_chunk = nullptr;
 	_parent = nullptr;
 }
 
 Octree::Octree(const BoundingBox& area, const PhysicalObjects& objects) :
-	_children{}, _area(area), _objects(objects)
+	_children{}, _lodMeshes{}, _area(area), _objects(objects)
 {
 	_timeToLive = -1;
 	_availableLifetime = _initialAvailableLifetime;
 	_chunkChildren = 0;
 	_physicChildren = 0;
 	_chunkMesh = nullptr;
+	_lodScheduled = 0;
+	_lod = 0;
 	_chunk = nullptr;
 	_parent = nullptr;
 }
 
 Octree::Octree(const BoundingBox& area) :
-	_children{}, _area(area)
+	_children{}, _lodMeshes{}, _area(area)
 {
 	_timeToLive = -1;
 	_availableLifetime = _initialAvailableLifetime;
 	_chunkChildren = 0;
 	_physicChildren = 0;
 	_chunkMesh = nullptr;
+	_lodScheduled = 0;
+	_lod = 0;
 	_chunk = nullptr;
 	_parent = nullptr;
 }
 
 Octree::Octree(const BoundingBox& area, const Chunks& chunks) :
-	_parent(NULL), _children{},
+	_parent(NULL), _children{}, _lodMeshes{},
 	_area(area), _chunks(chunks)
 {
 	_timeToLive = -1;
@@ -49,6 +57,8 @@ Octree::Octree(const BoundingBox& area, const Chunks& chunks) :
 	_chunkChildren = 0;
 	_physicChildren = 0;
 	_chunkMesh = nullptr;
+	_lodScheduled = 0;
+	_lod = 0;
 	_chunk = nullptr;
 	_parent = nullptr;
 }
@@ -56,8 +66,7 @@ Octree::Octree(const BoundingBox& area, const Chunks& chunks) :
 Octree::~Octree()
 {
 	/* And delete chunk resources if existing */
-	delete _chunk;
-	delete _chunkMesh;
+	DeleteChunk();
 }
 
 void
@@ -200,16 +209,9 @@ Octree::BuildTree()
 		if (_chunks.empty())
 			return;
 
-		/* Add chunk from the list */
-		_chunk = _chunks.back();
+		/* Add chunk from the list. Mesh will be generated during update, when all neighbours are already in the tree */
+		SetChunk(_chunks.back(), nullptr);
 		_chunks.clear();
-
-		assert(_chunkMesh == nullptr, "Mesh should be nullptr when creating tree, there is: %s", _chunkMesh->GetName().c_str());
-		
-		_chunkMesh = new VoxelMesh;
-		
-		_chunkMesh->Init(_chunk->GetName());
-		_chunk->GenerateMesh(_chunkMesh);
 	}
 
 	BoundingBox childAreas[8];
@@ -269,10 +271,8 @@ Octree::CreateChildNode(const BoundingBox& area, Chunk *chunk, VoxelMesh* chunkM
 	
 	assert(child->IsSmallestLeaf(), "Cannot create child node with chunk if it is not smallest leaf");
 	
-	child->_chunk = chunk;
-	child->_chunkMesh = chunkMesh;
-
 	child->_parent = this;
+	child->SetChunk(chunk, chunkMesh);
 
 	return child;
 }
@@ -285,23 +285,405 @@ Octree::UpdateChunk()
 
 	/*Check if chunk is empty and delete it if so */
 	if (_chunk->IsEmpty()) {
-		delete _chunk;
-		delete _chunkMesh;
+		/* Edited chunk is kept without meshes, otherwise the streamer would generate it again together with the dug out voxels */
+		if (_chunk->IsEdited() && !_chunk->HasChanged())
+			return;
+
+		/* Faces of the neighbours covered by this chunk must become visible */
+		if (_chunkMesh != nullptr)
+			InvalidateNeighbours(0x3f);
 
-		_chunk = nullptr;
-		_chunkMesh = nullptr;
+		if (_chunk->IsEdited()) {
+			DeleteChunkMeshes();
+			_chunk->Validate();
+		}
+		else {
+			DeleteChunk();
+		}
 		return;
 	}
 
 	/* Generate mesh if chunk has changed */
 	if (_chunk->HasChanged()) {
+		/* With workers, new chunk stays empty until its first mesh is taken in UpdateMeshes, meshing it here would stall streaming */
 		if (_chunkMesh == nullptr) {
 			_chunkMesh = new VoxelMesh;
 			_chunkMesh->Init(_chunk->GetName());
 		}
-		_chunk->GenerateMesh(_chunkMesh);
+		/* Neighbours meshed earlier are using voxels from the faces of this chunk, so they must be updated too */
+		else {
+			InvalidateNeighbours(_chunk->GetChangedBorders());
+		}
+
+		Chunk::Border border;
+		GetChunkBorder(&border);
+
+		/* Chunk with the same voxels and neighbours has been meshed already, e.g. before placing and digging a voxel */
+		MeshCache::Key key = MeshCache::GetKey(*_chunk, border);
+		VoxelMesh* cached = _meshCache != nullptr ? _meshCache->Acquire(key) : nullptr;
+		if (cached != nullptr) {
+			if (_meshWorkers != nullptr)
+				_meshWorkers->Cancel(_chunk);
+			ReleaseChunkMesh();
+			_chunkMesh = cached;
+			_chunk->Validate();
+		}
+		/*
+		* Small edits are patched into the current mesh right away, only changed slices are meshed and uploaded.
+		* It cannot be done while the background job is pending, because its mesh will replace the current one.
+		*/
+		else if (_chunk->CanUpdateMesh(_chunkMesh) && (_meshWorkers == nullptr || !_meshWorkers->IsPending(_chunk))) {
+			MakeChunkMeshPrivate();
+			_chunk->UpdateMesh(_chunkMesh, border);
+		}
+		/* Copy of the chunk is meshed in the background, old mesh is drawn until new one is taken in UpdateMeshes */
+		else if (_meshWorkers != nullptr) {
+			_meshKey = key;
+			_meshWorkers->Schedule(_chunk, border);
+			_chunk->Validate();
+		}
+		else {
+			MakeChunkMeshPrivate();
+			_chunk->GenerateMesh(_chunkMesh, border);
+			if (_meshCache != nullptr)
+				_meshCache->Insert(key, _chunkMesh);
+		}
+
+		/* Coarse meshes are out of date, but they are drawn until new ones are ready */
+		_lodScheduled = 0;
+	}
+
+	UpdateLodMesh();
+}
+
+void
+Octree::UpdateLodMesh()
+{
+	if (_lod == 0 || (_lodScheduled & (1 << (_lod - 1))))
+		return;
+
+	_lodScheduled |= 1 << (_lod - 1);
+
+	VoxelMesh*& mesh = _lodMeshes[_lod - 1];
+	if (mesh == nullptr) {
+		mesh = new VoxelMesh;
+		mesh->Init(_chunk->GetName());
+	}
+
+	if (_meshWorkers != nullptr)
+		_meshWorkers->ScheduleLod(_chunk, _lod);
+	else
+		_chunk->GenerateLodMesh(mesh, _lod);
+}
+
+int
+Octree::GetLod(const Vector3& position) const
+{
+	float distance = Vector3::Distance(position, _area.GetPosition());
+
+	int lod = 0;
+	for (float start = _lodDistance; distance >= start && lod < Chunk::lodLevels; start *= 2.0f)
+		++lod;
+
+	return lod;
+}
+
+void
+Octree::SetChunk(Chunk* chunk, VoxelMesh* chunkMesh)
+{
+	assert(IsSmallestLeaf(), "Chunk can be assigned only to the smallest leaf.");
+
+	_chunk = chunk;
+	_chunkMesh = chunkMesh;
+	GetRoot()->_chunkMap.Insert(ChunkMap::GetKey(_area.GetPosition()), this);
+
+	/* Faces of the neighbours meshed earlier may be covered by the new chunk, on every path that adds chunks to the tree */
+	InvalidateNeighbours(0x3f);
+}
+
+void
+Octree::DeleteChunk()
+{
+	if (_chunk != nullptr)
+		GetRoot()->_chunkMap.Remove(ChunkMap::GetKey(_area.GetPosition()));
+
+	DeleteChunkMeshes();
+	delete _chunk;
+	_chunk = nullptr;
+}
+
+void
+Octree::DeleteChunkMeshes()
+{
+	/* Mesh being generated for the chunk must not be delivered after deleting it */
+	if (_meshWorkers != nullptr && _chunk != nullptr)
+		_meshWorkers->Cancel(_chunk);
+
+	ReleaseChunkMesh();
+
+	for (int i = 0; i < Chunk::lodLevels; ++i) {
+		delete _lodMeshes[i];
+		_lodMeshes[i] = nullptr;
+	}
+	_lodScheduled = 0;
+}
+
+void
+Octree::UpdateMeshes()
+{
+	MeshWorkers::Result result;
+	for (int uploads = 0; uploads < _meshWorkers->GetMaxUploadsPerFrame() && _meshWorkers->Pop(&result); ++uploads) {
+		/* Cancelled chunks are never returned, so chunk is still stored in the tree */
+		Octree* node = GetChunkNode(result.chunk->GetOffset() + result.chunk->GetCenter());
+		if (node != nullptr && node->_chunk == result.chunk) {
+			if (result.lod == 0) {
+				/* Cached mesh is drawn by other chunks or kept for the previous state of the chunk, so new one is created instead of overwriting it */
+				if (_meshCache != nullptr && _meshCache->Contains(node->_chunkMesh)) {
+					_meshCache->Release(node->_chunkMesh);
+					node->_chunkMesh = new VoxelMesh;
+					node->_chunkMesh->Init(node->_chunk->GetName());
+				}
+				node->_chunkMesh->SwapVertices(result.mesh);
+
+				/* Only the newest mesh matches the key computed when the job was scheduled */
+				if (_meshCache != nullptr && !_meshWorkers->IsPending(node->_chunk))
+					_meshCache->Insert(node->_meshKey, node->_chunkMesh);
+			}
+			else if (node->_lodMeshes[result.lod - 1] != nullptr) {
+				node->_lodMeshes[result.lod - 1]->SwapVertices(result.mesh);
+			}
+		}
+
+		_meshWorkers->Release(result.mesh);
+	}
+}
+
+void
+Octree::MakeChunkMeshPrivate()
+{
+	if (_meshCache == nullptr || !_meshCache->Contains(_chunkMesh))
+		return;
+
+	/*
+	* Cached mesh can be drawn by other chunks and it stays in the cache after release, so the chunk restored
+	* to the current state gets it back. It is copied and only the copy is modified.
+	*/
+	VoxelMesh* cached = _chunkMesh;
+	_chunkMesh = new VoxelMesh;
+	_chunkMesh->Init(_chunk->GetName());
+	_chunkMesh->CopyVertices(*cached);
+	_meshCache->Release(cached);
+}
+
+void
+Octree::ReleaseChunkMesh()
+{
+	if (_meshCache != nullptr && _meshCache->Contains(_chunkMesh))
+		_meshCache->Release(_chunkMesh);
+	else
+		delete _chunkMesh;
+	_chunkMesh = nullptr;
+}
+
+void
+Octree::GetChunkBorder(Chunk::Border* border)
+{
+	Octree* root = GetRoot();
+	Vector3 center = _chunk->GetOffset() + _chunk->GetCenter();
+
+	for (int front = 0; front < 2; ++front) {
+		for (int dir = 0; dir < 3; ++dir) {
+			Vector3 neighbourCenter = center;
+			neighbourCenter[dir] += front ? (float)Chunk::dimension : -(float)Chunk::dimension;
+
+			/* Front layer of this chunk is touching back face of the neighbour and vice versa */
+			Chunk* neighbour = root->GetChunkAt(neighbourCenter);
+			if (neighbour != nullptr)
+				neighbour->GetFaceMask(dir, !front, border->layers[dir][front]);
+			else
+				memset(border->layers[dir][front], 0, sizeof(border->layers[dir][front]));
+		}
+	}
+}
+
+void
+Octree::InvalidateNeighbours(uint8_t faces)
+{
+	if (faces == 0)
+		return;
+
+	Octree* root = GetRoot();
+	Vector3 center = _chunk->GetOffset() + _chunk->GetCenter();
+
+	for (int face = 0; face < 6; ++face) {
+		if (!(faces & (1 << face)))
+			continue;
+
+		Vector3 neighbourCenter = center;
+		neighbourCenter[face % 3] += face >= 3 ? (float)Chunk::dimension : -(float)Chunk::dimension;
+
+		Chunk* neighbour = root->GetChunkAt(neighbourCenter);
+		/* Neighbour is touching this chunk with its opposite face */
+		if (neighbour != nullptr)
+			neighbour->InvalidateFace(face % 3, face < 3);
 	}
+}
+
+bool
+Octree::RemoveChunk(const Vector3& coordinates)
+{
+	Octree* node = GetChunkNode(coordinates);
+	if (node == nullptr || node->_chunk == nullptr)
+		return false;
+
+	/* Faces of the neighbours covered by this chunk must become visible */
+	if (node->_chunkMesh != nullptr)
+		node->InvalidateNeighbours(0x3f);
 
+	/* Node will be removed by its parent after its lifetime ends */
+	node->DeleteChunk();
+	return true;
+}
+
+void
+Octree::Enclose(const BoundingBox& area)
+{
+	assert(IsRoot(), "Only root can be resized.");
+
+	/* Grow twice at a time towards the area, current tree becomes one of the children */
+	while (!_area.IsContaining(area)) {
+		Vector3 center = _area.GetPosition();
+		Vector3 dimension = _area.GetDimension();
+		Vector3 newCenter;
+		for (int i = 0; i < 3; ++i)
+			newCenter[i] = center[i] + (area.GetPosition()[i] >= center[i] ? 0.5f : -0.5f) * dimension[i];
+
+		Octree* child = new Octree(_area);
+		MoveChildren(child);
+		_area.Set(newCenter, dimension * 2.0f);
+
+		if (!child->HasChild()) {
+			DeleteBranch(child);
+			continue;
+		}
+
+		BoundingBox childAreas[8];
+		SubdivideNode(childAreas);
+		for (int i = 0; i < 8; ++i) {
+			if (childAreas[i].IsContaining(center)) {
+				_children[i] = child;
+				child->_parent = this;
+				if (child->_chunkChildren != 0)
+					_chunkChildren |= (uint8_t)(1 << i);
+				if (child->_physicChildren != 0)
+					_physicChildren |= (uint8_t)(1 << i);
+				break;
+			}
+		}
+	}
+
+	/* Shrink while the only used child contains the area, so the tree does not get deeper while travelling */
+	while (true) {
+		uint8_t used = _chunkChildren | _physicChildren;
+		if (used == 0 || (used & (used - 1)) != 0)
+			return;
+
+		Octree* child = _children[bitScanForward(used)];
+		if (child->IsSmallestLeaf() || !child->_area.IsContaining(area))
+			return;
+		for (PhysicalObjects::iterator it = _objects.begin(); it != _objects.end(); ++it)
+			if (!child->_area.IsContaining((*it)->GetCollider()))
+				return;
+
+		/* Other children are empty, they are only waiting for the end of their lifetime */
+		for (int i = 0; i < 8; ++i) {
+			if (_children[i] != child)
+				DeleteBranch(_children[i]);
+			_children[i] = nullptr;
+		}
+		_chunkChildren = 0;
+		_physicChildren = 0;
+
+		child->MoveChildren(this);
+		_objects.splice(_objects.end(), child->_objects);
+		_area = child->_area;
+		delete child;
+	}
+}
+
+void
+Octree::MoveChildren(Octree* target)
+{
+	for (int i = 0; i < 8; ++i) {
+		target->_children[i] = _children[i];
+		if (_children[i] != nullptr)
+			_children[i]->_parent = target;
+		_children[i] = nullptr;
+	}
+
+	target->_chunkChildren = _chunkChildren;
+	target->_physicChildren = _physicChildren;
+	_chunkChildren = 0;
+	_physicChildren = 0;
+}
+
+void
+Octree::DeleteBranch(Octree* node)
+{
+	if (node == nullptr)
+		return;
+
+	/* Children which are not used anymore are still allocated until their parent is deleted */
+	for (int i = 0; i < 8; ++i)
+		DeleteBranch(node->_children[i]);
+	delete node;
+}
+
+Chunk*
+Octree::GetChunkAt(const Vector3& coordinates)
+{
+	Octree* node = GetChunkNode(coordinates);
+	return node != nullptr ? node->_chunk : nullptr;
+}
+
+Voxel
+Octree::GetVoxel(const Vector3& coordinates)
+{
+	Chunk* chunk = GetChunkAt(coordinates);
+	return chunk != nullptr ? chunk->Get(coordinates) : Voxel();
+}
+
+Chunk*
+Octree::FindChunk(const Vector3& coordinates)
+{
+	Octree* node = GetRoot();
+	while (node != nullptr && node->_area.IsContaining(coordinates)) {
+		if (node->_chunk != nullptr)
+			return node->_chunk;
+
+		/* Only branches marked as containing chunks are followed, the same way as during drawing */
+		Octree* next = nullptr;
+		for (int i = 0; i < 8 && next == nullptr; ++i) {
+			Octree* child = node->_children[i];
+			if ((node->_chunkChildren & (1 << i)) != 0 && child != nullptr && child->_area.IsContaining(coordinates))
+				next = child;
+		}
+		node = next;
+	}
+	return nullptr;
+}
+
+size_t
+Octree::GetChunksCount()
+{
+	return GetRoot()->_chunkMap.GetSize();
+}
+
+Octree*
+Octree::GetChunkNode(const Vector3& coordinates)
+{
+	/* Leaves are matching the chunks, so point belongs to the leaf stored under the key of its chunk */
+	return GetRoot()->_chunkMap.Find(ChunkMap::GetKey(coordinates));
 }
 
 void
@@ -312,7 +694,7 @@ Octree::RemoveUnusedChildren()
 	for (uint8_t used = usedChildren, i = 0; used > 0; used >>= 1, ++i) {
 		/* If branch timed out, delete it */
 		if ((used & 1) && _children[i]->_timeToLive == 0) {
-			delete _children[i];
+			DeleteBranch(_children[i]);
 			_children[i] = nullptr;
 
 			_chunkChildren &= ~(uint8_t)(1 << i);
@@ -371,6 +753,10 @@ Octree::Update()
 		}
 	}
 
+	/* Meshes finished since last frame are taken once for the whole tree */
+	if (IsRoot() && _meshWorkers != nullptr)
+		UpdateMeshes();
+
 	/* Update all chunks before physical objects */
 	UpdateChunk();
 
@@ -553,8 +939,10 @@ Octree::Insert(Chunk* chunk, VoxelMesh* chunkMesh)
 	 * as physical objects, and it will be easier to check collisions that way.
 	 */
 	if (IsSmallestLeaf()) {
-		assert(_chunk != nullptr, "There is already chunk in that node: %s", _chunk->GetName().c_str());
-		_chunk = chunk;
+		assert(_chunk == nullptr, "There is already chunk in that node: %s", _chunk->GetName().c_str());
+		/* Neighbours are invalidated there, faces covered by the new chunk do not have to be drawn anymore */
+		SetChunk(chunk, chunkMesh);
+		_timeToLive = -1;
 		return;
 	}
 
@@ -574,16 +962,13 @@ Octree::Insert(Chunk* chunk, VoxelMesh* chunkMesh)
 		/* Check inside each child node */
 		for (int i = 0; i < 8; ++i) {
 			if (childAreas[i].IsContaining(chunkCenter)) {
-				/* If node is already existing, just insert it */
-				if (_children[i] != nullptr) {
-					_children[i]->Insert(chunk, chunkMesh);
-				}
-				/* In other case, we must create child node */
-				else {
-					_children[i] = CreateChildNode(childAreas[i], chunk, chunkMesh);
-					if (!_children[i]->IsSmallestLeaf())
-						_children[i]->Insert(chunk);
+				/* In case there is no node yet, we must create one on the way to the smallest leaf */
+				if (_children[i] == nullptr) {
+					_children[i] = new Octree(childAreas[i]);
+					_children[i]->_parent = this;
 				}
+				_children[i]->_timeToLive = -1;
+				_children[i]->Insert(chunk, chunkMesh);
 				_chunkChildren |= (uint8_t)(1 << i);
 
 				fits = true;
@@ -640,10 +1025,16 @@ Octree::Draw(Renderer* renderer)
 		return;
 	}
 
-	if (_chunk != nullptr) {
-		assert(_chunkMesh != nullptr, "%s mesh not existing", _chunk->GetName().c_str());
+	/* Mesh of the new chunk is created during next update */
+	if (_chunk != nullptr && _chunkMesh != nullptr) {
+		/* Far chunks are drawn with coarse mesh, full one is used until coarse mesh is ready */
+		_lod = GetLod(camera->GetPosition());
+		VoxelMesh* mesh = _chunkMesh;
+		if (_lod > 0 && _lodMeshes[_lod - 1] != nullptr && _lodMeshes[_lod - 1]->GetQuadsNumber() > 0)
+			mesh = _lodMeshes[_lod - 1];
+
 		renderer->SetModelMatrix(_chunk->GetModelMatrix());
-		_chunkMesh->Draw(renderer);
+		mesh->Draw(renderer);
 	}
 
 	/* Render only chunks */
@@ -763,75 +1154,18 @@ Octree::Add(const Chunks& chunks)
 void
 Octree::CheckRayCollision(Ray *ray, RayIntersection* intersectionInfo)
 {
-	/* Check collision with chunk if we are at the smallest leaft */
-	if (IsSmallestLeaf()) {
-		/* If there is no chunk, we want to shoot our ray, until it will either end, or stop fitting in the area */
-		if (_chunk == nullptr) {
-			while (!ray->HasEnded() && _area.IsContaining(ray->Advance(0.25f)));
+	/* Ray is walking from chunk to chunk, which are found through the map instead of going up and down the tree */
+	const ChunkMap& chunkMap = GetRoot()->_chunkMap;
+	while (!ray->HasEnded() && !intersectionInfo->CollisionFound()) {
+		ChunkMap::Key key = ChunkMap::GetKey(ray->GetCurrentPosition());
+		Octree* node = chunkMap.Find(key);
+
+		if (node != nullptr && node->_chunk->GetSolidCount() > 0) {
+			intersectionInfo->TestIntersection(ray, node->_chunk);
 		}
+		/* If there is no chunk or it has no solid voxels, we want to shoot our ray until it leaves the chunk */
 		else {
-			intersectionInfo->TestIntersection(ray, _chunk);
-		}
-
-		if (ray->HasEnded() || intersectionInfo->CollisionFound()) {
-			return;
-		}
-		else {
-			Octree *node = this;
-
-			/* Push object up if it is no more fitting into node */
-			while (!node->_area.IsContaining(ray->GetCurrentPosition()))
-				if (node->HasParent())
-					node = node->_parent;
-				else
-					break;
-
-			/* Insert it into the parent */
-			node->CheckRayCollision(ray, intersectionInfo);
-		}
-
-		return;
-	}
-
-	BoundingBox childAreas[8];
-	SubdivideNode(childAreas);
-
-
-	/* We must determine which child is holding us and */
-	bool fitted = false;
-	while (!fitted && !ray->HasEnded() && !intersectionInfo->CollisionFound()) {
-		Vector3 rayPos = ray->GetCurrentPosition();
-
-		/* If we are still into the area, check collision with children */
-		if (_area.IsContaining(rayPos)) {
-			if (HasChild())
-				for (uint8_t used = _physicChildren | _chunkChildren, i = 0; used > 0; used >>= 1, ++i)
-					if (used & 1)
-						if (childAreas[i].IsContaining(rayPos)) {
-							_children[i]->CheckRayCollision(ray, intersectionInfo);
-							return;
-						}
-
-			ray->Advance(0.25f);
-		}
-		/* If we are not fitting, find the best parent */
-		else {
-			Octree *node = this;
-
-			/* Push object up if it is no more fitting into node */
-			while (!node->_area.IsContaining(ray->GetCurrentPosition()))
-				if (node->HasParent())
-					node = node->_parent;
-				else
-					break;
-
-			/* If ray is out of game range, just drop it */
-			if (node->IsRoot() && !node->_area.IsContaining(ray->GetCurrentPosition()))
-				return;
-
-			/* Insert it into the parent */
-			node->CheckRayCollision(ray, intersectionInfo);
-			return;
+			while (!ray->HasEnded() && ChunkMap::GetKey(ray->Advance(0.25f)) == key);
 		}
 	}
 }
@@ -853,53 +1187,19 @@ Octree::GetObjectsList(PhysicalObject* object, PhysicalObjectsVector* physicalOb
 void 
 Octree::GetCollidingChunksList(const BoundingBox& box, Chunks* collidedChunks)
 {
-	/* Add chunk if at bottom */
-	if (IsSmallestLeaf()) {
-		if (_chunk != nullptr)
-			collidedChunks->push_back(_chunk);
-		return;
-	}
-
-	/* We will be treating AABB as a points to find all chunks. Because of the size, there will be max 8 neighbours. */
-	const Vector3 &min = box.GetMinimas();
-	const Vector3 &max = box.GetMaximas();
-	Vector3 pts[8] = {
-		Vector3(min.x, min.y, min.z),
-		Vector3(min.x, min.y, max.z),
-		Vector3(min.x, max.y, min.z),
-		Vector3(min.x, max.y, max.z),
-		Vector3(max.x, min.y, min.z),
-		Vector3(max.x, min.y, max.z),
-		Vector3(max.x, max.y, min.z),
-		Vector3(max.x, max.y, max.z)
-	};
-
-	/* Check each point */
-	for (int n = 0; n < 8; ++n) {
-		Octree* node = this;
-
-		/* Find the smallest childr which contains that point */
-		while (!node->IsSmallestLeaf()) {
-			bool fitted = false;
-			if (node->HasChild()) {
-				for (uint8_t used = node->_chunkChildren, i = 0; used > 0; used >>= 1, ++i) {
-					if (used & 1) {
-						if (node->_children[i]->_area.IsContaining(pts[n])) {
-							fitted = true;
-							node = node->_children[i];
-							break;
-						}
-					}
-				}
+	/* Box is not bigger than a chunk, so it touches at most 2 chunks along each axis */
+	ChunkMap::Key low = ChunkMap::GetKey(box.GetMinimas());
+	ChunkMap::Key high = ChunkMap::GetKey(box.GetMaximas());
+
+	const ChunkMap& chunkMap = GetRoot()->_chunkMap;
+	for (int z = low.z; z <= high.z; ++z) {
+		for (int y = low.y; y <= high.y; ++y) {
+			for (int x = low.x; x <= high.x; ++x) {
+				Octree* node = chunkMap.Find({ x, y, z });
+				if (node != nullptr)
+					collidedChunks->push_back(node->_chunk);
 			}
-			if (!fitted)
-				break;
 		}
-
-		/* If we are at the bottom, we can add chunk */
-		if (node->IsSmallestLeaf() && node->_chunk != nullptr)
-			if (std::find(collidedChunks->begin(), collidedChunks->end(), node->_chunk) == collidedChunks->end())
-				collidedChunks->push_back(node->_chunk);
 	}
 }
 
@@ -911,13 +1211,26 @@ Octree::CheckTerrainIntersections(PhysicalObject* object, CollisionInfo* info)
 		   object->GetCollider().GetDimension().z <= Chunk::dimension,
 		   "Object's size cannot be higher than chunk size!");
 
-	BoundingBox childAreas[8];
-	SubdivideNode(childAreas);
-
 	Chunks usedChunks;
 	const BoundingBox& obj = object->GetCollider();
 	GetCollidingChunksList(obj, &usedChunks);
 
+	/* Chunks without solid voxels inside the collider cannot collide, treat them as not existing ones */
+	for (Chunks::iterator it = usedChunks.begin(); it != usedChunks.end();) {
+		const Vector3& chunkOffset = (*it)->GetOffset();
+		int low[3], high[3];
+		for (int i = 0; i < 3; ++i) {
+			low[i] = std::max(0, (int)floor(obj.GetMinimas()[i] - chunkOffset[i]));
+			high[i] = std::min(Chunk::dimension - 1, (int)floor(obj.GetMaximas()[i] - chunkOffset[i]));
+		}
+
+		if (low[0] > high[0] || low[1] > high[1] || low[2] > high[2] ||
+			!(*it)->AnySolid(low[0], low[1], low[2], high[0], high[1], high[2]))
+			it = usedChunks.erase(it);
+		else
+			++it;
+	}
+
 	if (usedChunks.empty())
 		return;
 
@@ -1076,38 +1389,30 @@ Octree::CheckTerrainIntersections(PhysicalObject* object, CollisionInfo* info)
 					}
 					trunCoords[colD] = minCoords[colD];
 
-					/* Get voxel and check bottom layer first */
-					const Voxel& firstVox = chunks[vIndex]->GetLocal(trunCoords[0], trunCoords[1], trunCoords[2]);
-					/* If there is something, we must check it to the top */
-					if (!firstVox.IsEmpty()) {
+					/* Check bottom layer first, if there is something, we must check it to the top */
+					if (chunks[vIndex]->IsSolidLocal(trunCoords[0], trunCoords[1], trunCoords[2])) {
 						bool empty = true;
 						int dIndex = vIndex;
 
 						bool trunD = truncated[colD];
 
-						/* Skip first element */
-						for (int d = minCoords[colD] + 1; d <= maxCoords[colD]; ++d) {
+						/* Skip first element, rest of the column inside each chunk is checked at once using occupancy mask */
+						for (int d = minCoords[colD] + 1; d <= maxCoords[colD];) {
 							if (!trunD && d >= Chunk::dimension) {
 								trunD = true;
 								dIndex += dirOffsets[colD];
 							}
+							int end = std::min(maxCoords[colD], (d / Chunk::dimension + 1) * Chunk::dimension - 1);
 							trunCoords[colD] = d % Chunk::dimension;
 
-							if (chunks[dIndex] == nullptr) {
-								if (d >= Chunk::dimension)
-									break;
-								else
-									d = Chunk::dimension - 1;
-								continue;
-							}
-
-							const Voxel& nextVox = chunks[dIndex]->GetLocal(trunCoords[0], trunCoords[1], trunCoords[2]);
 							/* If there was voxel above, we cannot continue, it we must change another voxel at the bottom layer */
-							if (!nextVox.IsEmpty()) {
+							if (chunks[dIndex] != nullptr &&
+								chunks[dIndex]->FirstSolid(trunCoords[0], trunCoords[1], trunCoords[2], colD, end % Chunk::dimension) != -1) {
 								empty = false;
 								anyVoxel = true;
 								break;
 							}
+							d = end + 1;
 						}
 						/* If there was no voxel above bottom one, there could be a collision from that side */
 						if (empty) {
@@ -1161,36 +1466,29 @@ Octree::CheckTerrainIntersections(PhysicalObject* object, CollisionInfo* info)
 						continue;
 					}
 
-					trunCoords[colD] = maxCoords[colD] % 16;
+					trunCoords[colD] = maxCoords[colD] % Chunk::dimension;
 					/* We are adding offset there */
-					const Voxel& firstVox = chunks[vIndex + offset]->GetLocal(trunCoords[0], trunCoords[1], trunCoords[2]);
-					if (!firstVox.IsEmpty()) {
+					if (chunks[vIndex + offset]->IsSolidLocal(trunCoords[0], trunCoords[1], trunCoords[2])) {
 						bool empty = true;
 						int dIndex = vIndex;
 
 						bool trunD = truncated[colD];
 						/* And going from bottom to top without last element */
-						for (int d = minCoords[colD]; d <= maxCoords[colD] - 1; ++d) {
+						for (int d = minCoords[colD]; d <= maxCoords[colD] - 1;) {
 							if (!trunD && d >= Chunk::dimension) {
 								trunD = true;
 								dIndex += dirOffsets[colD];
 							}
+							int end = std::min(maxCoords[colD] - 1, (d / Chunk::dimension + 1) * Chunk::dimension - 1);
 							trunCoords[colD] = d % Chunk::dimension;
 
-							if (chunks[dIndex] == nullptr) {
-								if (d >= Chunk::dimension)
-									break;
-								else
-									d = Chunk::dimension - 1;
-								continue;
-							}
-
-							const Voxel& nextVox = chunks[dIndex]->GetLocal(trunCoords[0], trunCoords[1], trunCoords[2]);
-							if (!nextVox.IsEmpty()) {
+							if (chunks[dIndex] != nullptr &&
+								chunks[dIndex]->FirstSolid(trunCoords[0], trunCoords[1], trunCoords[2], colD, end % Chunk::dimension) != -1) {
 								empty = false;
 								anyVoxel = true;
 								break;
 							}
+							d = end + 1;
 						}
 						if (empty) {
 							collisions[3 + i] = true;
@@ -1235,6 +1533,24 @@ Octree::Insert(const Voxel& voxel, Vector3 coordinates)
 	/*  Create bounding box from voxel coordinates - it will be bounding box of the voxel */
 	BoundingBox box(coordinates + Vector3(0.5f, 0.5f, 0.5f), Vector3(1.0f, 1.0f, 1.0f));
 
+	/*
+	* If chunk already exists, root takes its leaf from the map. Objects which can collide with the voxel are stored
+	* in the nodes on the path from the leaf to the root, the same ones which are visited while going down the tree.
+	*/
+	Octree* leaf = IsRoot() ? GetChunkNode(coordinates) : nullptr;
+	if (leaf != nullptr) {
+		for (Octree* node = leaf; node != nullptr; node = node->_parent)
+			for (PhysicalObjects::iterator it = node->_objects.begin(); it != node->_objects.end(); ++it)
+				if ((*it)->GetCollider().IsColliding(box))
+					return;
+
+		if (leaf->_chunk->Get(coordinates).IsEmpty()) {
+			leaf->_chunk->Set(coordinates, voxel.GetType());
+			leaf->_chunk->MarkEdited();
+		}
+		return;
+	}
+
 	/* Check for collision with all physical objects */
 	for (PhysicalObjects::iterator it = _objects.begin(); it != _objects.end(); ++it)
 		if ((*it)->GetCollider().IsColliding(box))
@@ -1244,10 +1560,12 @@ Octree::Insert(const Voxel& voxel, Vector3 coordinates)
 	if (IsSmallestLeaf()) {
 		/* if it is not existing, create one */
 		if (_chunk == nullptr)
-			_chunk = new Chunk(_area.GetMinimas());
+			SetChunk(new Chunk(_area.GetMinimas()), nullptr);
 
-		if (_chunk->Get(coordinates).IsEmpty())
+		if (_chunk->Get(coordinates).IsEmpty()) {
 			_chunk->Set(coordinates, voxel.GetType());
+			_chunk->MarkEdited();
+		}
 		return;
 	}
 
@@ -1274,12 +1592,13 @@ Octree::Insert(const Voxel& voxel, Vector3 coordinates)
 						/* For negative we must use different formula */
 						else {
 							offset[i] = (float)((int)coordinates[i] / Chunk::dimension - 1) * Chunk::dimension;
-							if ((int)coordinates[i] % 16 == 0)
+							if ((int)coordinates[i] % Chunk::dimension == 0)
 								offset[i] += 1;
 						}
 					}
 					Chunk* chunk = new Chunk(offset);
 					chunk->Set(coordinates, voxel.GetType());
+					chunk->MarkEdited();
 					Insert(chunk);
 				}
 				/* Add chunk info */
@@ -4,6 +4,9 @@
 #include "Resources/Voxels/Chunk.h"
 #include "Resources/Renderables/Lines.h"
 #include "Engine/Physic/RayIntersection.h"
+#include "MeshWorkers.h"
+#include "MeshCache.h"
+#include "ChunkMap.h"
 
 #include <queue>
 #include <list>
@@ -88,6 +91,28 @@ public:
 	/* Get pointer to the root of the tree. */
 	Octree* GetRoot();
 
+	/* Get chunk containing given point or nullptr if there is no chunk. Chunk is found through the map, without walking down the tree. */
+	Chunk* GetChunkAt(const Vector3& coordinates);
+	/* Get chunk containing given point by walking down the tree, without the map. It is slower than GetChunkAt and used to check the map. */
+	Chunk* FindChunk(const Vector3& coordinates);
+	/* Get voxel at given point, it is empty if there is no chunk */
+	Voxel GetVoxel(const Vector3& coordinates);
+	/* Get number of chunks stored in the tree */
+	size_t GetChunksCount();
+	/* Delete chunk containing given point together with its meshes. Returns false if there is no chunk. */
+	bool RemoveChunk(const Vector3& coordinates);
+	/*
+	* Resize the root, so it contains given area. Root grows twice at a time and the current tree becomes one of its children,
+	* then it shrinks to its only used child while the child contains the area. Chunks and objects are not moved.
+	* Area must stay aligned to the chunks, so dimension of the root must be chunk dimension multiplied by power of two.
+	*/
+	void Enclose(const BoundingBox& area);
+
+	/* Set workers generating meshes of the changed chunks in the background. Without workers meshes are generated during Update. */
+	static void SetMeshWorkers(MeshWorkers* meshWorkers);
+	/* Set cache sharing meshes between chunks with the same contents. Without cache each chunk has its own mesh. */
+	static void SetMeshCache(MeshCache* meshCache);
+
 	/* Convert Octree to string - respects only physical objects, not chunks. Lvl should be left with default value */
 	std::string ToString(int lvl = 0) const;
 private:
@@ -106,8 +131,13 @@ private:
 	Chunks _chunks;				/* Chunks that are stored in this node and have to be delivered to children. Used only during initial build. This do not 
 								   have to be list, because all chunks will be delivered to child nodes for sure, until only one is left */
 	Chunk* _chunk;				/* Chunk assigned to this node. In other nodes than smallest ones, this should be nullptr. Empty chunks are stored as nullptr too */
-	VoxelMesh* _chunkMesh;		/* Mesh for the chunk. */
+	VoxelMesh* _chunkMesh;		/* Mesh for the chunk. It can be shared with other chunks through the mesh cache. */
+	MeshCache::Key _meshKey;	/* Key of the chunk at the time of scheduling the newest mesh job */
+	VoxelMesh* _lodMeshes[Chunk::lodLevels];	/* Coarse meshes of the chunk, created when they are needed. First one is 2 times coarser. */
+	uint8_t _lodScheduled;		/* Bit (lod - 1) is set when coarse mesh is up to date or is being generated */
+	int _lod;					/* Level of detail chosen during last drawing, 0 is full detail */
 	uint8_t _chunkChildren;		/* Bitfield indicating which branches are containing any not empty chunks. */
+	ChunkMap _chunkMap;			/* Leaves with chunks by coordinates of the chunks, used only in the root */
 
 	/* Time constrains */
 	int _availableLifetime;		/* Lifetime that will be assigned to timeToLive when node will become empty. It wil be increased each time the node is used. */
@@ -117,8 +147,11 @@ private:
 	const float _minimumSize = (float)Chunk::dimension; /* Minimum dimension of the node. Chunk size is good if chunk is not too big. */
 	const int _initialAvailableLifetime = 8;			/* Initial value for available lifetime */
 	const int _maximumLifetime = 64;					/* Maximum availableLifetime value*/
+	const float _lodDistance = 4.0f * Chunk::dimension;	/* Distance to the camera where first coarse level starts, each next one starts twice as far */
 
 	static bool _built; /* Indicates that tree has been built for the first time */
+	static MeshWorkers* _meshWorkers; /* Workers generating chunk meshes, can be nullptr */
+	static MeshCache* _meshCache; /* Cache of the chunk meshes, can be nullptr */
 
 	/* Constructs node with given area and object list */
 	Octree(const BoundingBox& area, const PhysicalObjects& objects);
@@ -146,12 +179,39 @@ private:
 	void Insert(Chunk* chunk, VoxelMesh* chunkMesh = nullptr);
 
 
+	/* Move all children and their bitfields to the target node */
+	void MoveChildren(Octree* target);
+	/* Delete node with all its children, including the ones which are not used anymore */
+	static void DeleteBranch(Octree* node);
+
 	void BuildChunk(BoundingBox childAreas[8]);
 	void BuildObject(BoundingBox childAreas[8]);
 	void RemoveUnusedChildren();
 
 	/* Recaulculates meshes for changed chunks and deletes empty chunks */
 	void UpdateChunk();
+	/* Swap meshes of the chunks with meshes finished by workers, limited by maximum number of uploads per frame */
+	void UpdateMeshes();
+	/* Generate coarse mesh for the level of detail chosen during drawing if it is out of date */
+	void UpdateLodMesh();
+	/* Get level of detail for the node seen from given position */
+	int GetLod(const Vector3& position) const;
+	/* Delete chunk and all its meshes */
+	void DeleteChunk();
+	/* Delete all meshes of the chunk, chunk stays in the node */
+	void DeleteChunkMeshes();
+	/* Make sure that mesh of the chunk is not shared, so it can be modified */
+	void MakeChunkMeshPrivate();
+	/* Delete mesh of the chunk or remove reference to it if it is shared */
+	void ReleaseChunkMesh();
+	/* Assign chunk and its mesh to the smallest leaf, add the leaf to the chunk map of the root and invalidate neighbours of the chunk */
+	void SetChunk(Chunk* chunk, VoxelMesh* chunkMesh);
+	/* Get smallest leaf holding chunk which contains given point or nullptr if there is none */
+	Octree* GetChunkNode(const Vector3& coordinates);
+	/* Fill border of the chunk with opaque voxels of its neighbours */
+	void GetChunkBorder(Chunk::Border* border);
+	/* Mark neighbours lying next to given faces of the chunk as changed, bit (dir + 3 * front) is set for each face */
+	void InvalidateNeighbours(uint8_t faces);
 	/* Checks collisions for the objects in the node */
 	void CollisionCheck();
 	/* Get list of all collision for the objects in the node and save info into infos (it is vector of the CollisionInfo) */
@@ -162,13 +222,25 @@ private:
 	/* Get list of all objects */
 	void GetObjectsList(PhysicalObject* object, PhysicalObjectsVector* physicalObjects);
 	
-	/* Get list of all chunks colliding with given bounding box */
+	/* Get list of all chunks colliding with given bounding box, they are found through the chunk map */
 	void GetCollidingChunksList(const BoundingBox& box, Chunks* collidedChunks);
 
 	/* Add node's bounding box border points into the vector, used for drawing */
 	void AddLines(Vectors* lines);
 };
 
+inline void
+Octree::SetMeshWorkers(MeshWorkers* meshWorkers)
+{
+	_meshWorkers = meshWorkers;
+}
+
+inline void
+Octree::SetMeshCache(MeshCache* meshCache)
+{
+	_meshCache = meshCache;
+}
+
 inline void 
 Octree::SetBoundingArea(const BoundingBox& area)
 {
@@ -85,8 +85,8 @@ RayIntersection::TestIntersection(Ray* ray, Chunk* chunk)
 				between(coords.z, constraintLow.z, constraintHigh.z)) {
 				prevPos = coords;
 
-				const Voxel& voxel = chunk->Get(coords);
-				if (!voxel.IsEmpty()) {
+				/* Occupancy mask is answering without decoding the voxel */
+				if (chunk->IsSolid(coords)) {
 					_hittedChunk = chunk;
 					_voxelCoordinates = coords;
 					return true;
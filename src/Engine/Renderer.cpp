@@ -14,6 +14,8 @@ Renderer::Init()
 
 	_activeCamera = nullptr;
 	_clearColor = { 1.0f, 1.0f, 1.0f };
+	_voxelSize = 0.0f;
+	_voxelCenter = Vector3::zeroes;
 	_pipe = pipelineManager.GetPipeline("renderer" + std::to_string(++_rendererNumber));
 
 	glPointSize(40.0f);
@@ -193,6 +195,19 @@ Renderer::SetAtlasTileSize(float tileSize)
 	}
 }
 
+void
+Renderer::SetVoxelTransform(float voxelSize, const Vector3& center)
+{
+	if (_voxelSize != voxelSize) {
+		programManager.SetUniform(_vertShaders[VOXEL], "voxelSize", voxelSize);
+		_voxelSize = voxelSize;
+	}
+	if (_voxelCenter != center) {
+		programManager.SetUniform(_vertShaders[VOXEL], "voxelCenter", center);
+		_voxelCenter = center;
+	}
+}
+
 void
 Renderer::SetTexture(unsigned int tex)
 {
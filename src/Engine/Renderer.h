@@ -58,6 +58,9 @@ public:
 	*/
 	void SetAtlasTileSize(float tileSize);
 
+	/* Set voxel size and center of the voxel array for the next draw, used by Voxel shader to restore positions of packed vertices */
+	void SetVoxelTransform(float voxelSize, const Vector3& center);
+
 	/* Set ambient light color and strength. Can be used with direction for stering night and day */
 	void SetAmbientLight(const Vector3& color, float strength);
 	/* Set global light direction */
@@ -111,6 +114,8 @@ private:
 	unsigned int _tex;		/* Currently binded texture */
 
 	float _tileSize;	/* Atlas tile size in normalized UV coordinates */
+	float _voxelSize;	/* Last used voxel size */
+	Vector3 _voxelCenter; /* Last used center of the voxel array */
 
 	Matrix4 _modelMatrix;	/* Last used model matrix */
 	Matrix4 _viewMatrix;	/* Last used view matrix */
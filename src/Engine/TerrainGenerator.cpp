@@ -1,10 +1,21 @@
 #include "TerrainGenerator.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace vengine {
 
 const float TerrainGenerator::_baseDetails = 32.0f;
+const float TerrainGenerator::_maxRockDeviation = 3.4641016f; /* Limit of hashToNormal, 2 sqrt(3) */
+
+/* Planes of the noise used by the default hills, so heights, roughness and details are not correlated */
+static const float heightPlane = 0.2f;
+static const float roughPlane = 0.5f;
+static const float detailPlane = 0.3f;
+/* Caves are sampled this many voxels above their real position, so they are not correlated with the surface planes */
+static const int caveShift = 4096;
 
-TerrainGenerator::TerrainGenerator() : _perlinGenerator(518331203u)
+TerrainGenerator::TerrainGenerator() : _perlinGenerator(518331203u), _simplexGenerator(518331203u)
 {
 	_seed = 518331203u;
 	_seaOffset = 0;
@@ -12,11 +23,14 @@ TerrainGenerator::TerrainGenerator() : _perlinGenerator(518331203u)
 	_rockSharpness = 1.0f;
 	_smoothness = 256.0f;
 	_details = 32.0f;
-	_generator.seed(_seed);
-	_distribution = std::normal_distribution<float>(_rockOffset, _rockSharpness);
+	_spread = 32.0f;
+	_noiseType = PERLIN;
+	_caveScale = 48.0f;
+	_caveThreshold = 0.35f;
+	_caveDepth = 0;
 }
 
-TerrainGenerator::TerrainGenerator(unsigned int seed) : _perlinGenerator(seed)
+TerrainGenerator::TerrainGenerator(unsigned int seed) : _perlinGenerator(seed), _simplexGenerator(seed)
 {
 	_seed = seed;
 	_seaOffset = 0;
@@ -25,11 +39,13 @@ TerrainGenerator::TerrainGenerator(unsigned int seed) : _perlinGenerator(seed)
 	_smoothness = 256.0f;
 	_details = 32.0f;
 	_spread = 32.0f;
-	_generator.seed(_seed);
-	_distribution = std::normal_distribution<float>(_rockOffset, _rockSharpness);
+	_noiseType = PERLIN;
+	_caveScale = 48.0f;
+	_caveThreshold = 0.35f;
+	_caveDepth = 0;
 }
 
-TerrainGenerator::TerrainGenerator(int seaOffset, float rockOffset, float rockSharpness) : _perlinGenerator(518331203u)
+TerrainGenerator::TerrainGenerator(int seaOffset, float rockOffset, float rockSharpness) : _perlinGenerator(518331203u), _simplexGenerator(518331203u)
 {
 	_seed = 518331203u;
 
@@ -39,12 +55,13 @@ TerrainGenerator::TerrainGenerator(int seaOffset, float rockOffset, float rockSh
 	_smoothness = 256.0f;
 	_details = 32.0f;
 	_spread = 32.0f;
-
-	_generator.seed(_seed);
-	_distribution = std::normal_distribution<float>(_rockOffset, _rockSharpness);
+	_noiseType = PERLIN;
+	_caveScale = 48.0f;
+	_caveThreshold = 0.35f;
+	_caveDepth = 0;
 }
 
-TerrainGenerator::TerrainGenerator(unsigned int seed, int seaOffset, float rockOffset, float rockSharpness) : _perlinGenerator(seed)
+TerrainGenerator::TerrainGenerator(unsigned int seed, int seaOffset, float rockOffset, float rockSharpness) : _perlinGenerator(seed), _simplexGenerator(seed)
 {
 	_seed = seed;
 
@@ -54,23 +71,36 @@ TerrainGenerator::TerrainGenerator(unsigned int seed, int seaOffset, float rockO
 	_smoothness = 256.0f;
 	_details = 32.0f; 
 	_spread = 32.0f;
-
-	_generator.seed(_seed);
-	_distribution = std::normal_distribution<float>(_rockOffset, _rockSharpness);
+	_noiseType = PERLIN;
+	_caveScale = 48.0f;
+	_caveThreshold = 0.35f;
+	_caveDepth = 0;
 }
 
 
 
 Voxel
-TerrainGenerator::GetVoxel(int x, int y, int z)
+TerrainGenerator::GetVoxel(int x, int y, int z) const
 {
-	float height = _perlinGenerator.GetNoise(x / _smoothness, z / _smoothness, 0.2f);
-	float rough = _perlinGenerator.GetNoise(x / _smoothness, z / _smoothness, 0.7f);
-	float detail = _perlinGenerator.GetNoise(x / _details, z / _details, 0.3f);
-	height = (height + (rough * detail)) * _spread + _seaOffset;
+	float height;
+	if (!_shape.IsEmpty()) {
+		_shape.Fill(GetNoise(), (float)x, (float)z, 1, 1, &height);
+		height = height * _spread + _seaOffset;
+	}
+	else {
+		const Noise& noise = GetNoise();
+		height = noise.GetPlaneNoise(x / _smoothness, z / _smoothness, heightPlane);
+		float rough = noise.GetPlaneNoise(x / _smoothness, z / _smoothness, roughPlane);
+		float detail = noise.GetPlaneNoise(x / _details, z / _details, detailPlane);
+		height = (height + (rough * detail)) * _spread + _seaOffset;
+	}
 
-	/* How deep rocks will appear using normal distribution */
-	int rocks = (int)_distribution(_generator);
+	/* How deep rocks will appear using normal distribution hashed from the voxel position */
+	int rocks = (int)GetRockDepth(x, y, z);
+
+	/* Caves are compared with the height rounded the same way as in the height maps */
+	if (HasCaves() && y < height && IsCave(y, (int)height, GetCaveDensity(x, y, z)))
+		return Voxel(Voxel::NONE);
 
 	/* If we are below air level*/
 	if (y < height) {
@@ -89,40 +119,56 @@ TerrainGenerator::GetVoxel(int x, int y, int z)
 }
 
 bool
-TerrainGenerator::GetChunk(Chunk* source)
+TerrainGenerator::GetChunk(Chunk* source) const
 {
 	const int size = Chunk::dimension;
 	const Vector3& offset = source->GetOffset();
 	int added = 0;
 
-	/* First, generate height map for whole chunk */
-	int heightMap[size][size];
-	for (int z = 0; z < size; ++z) {
-		for (int x = 0; x < size; ++x) {
-			float height = _perlinGenerator.GetNoise((offset.x + x) / _smoothness, (offset.z + z) / _smoothness, 0.2f);
-			float rough = _perlinGenerator.GetNoise((offset.x + x) / _smoothness, (offset.z + z) / _smoothness, 0.5f);
-			float detail = _perlinGenerator.GetNoise((offset.x + x) / _details, (offset.z + z) / _details, 0.3f);
+	/* First, get height map of the column, it is shared by all chunks above and below */
+	HeightMapCache::HeightMap heightMap;
+	GetHeightMap((int)offset.x, (int)offset.z, &heightMap);
 
-			height = (height + (rough * detail)) * _spread + _seaOffset;
-			heightMap[z][x] = (int)height;
-		}
+	/* Most of the chunks are not touching the surface, so they are filled at once */
+	switch (ClassifyChunk((int)offset.y, heightMap)) {
+	case EMPTY:
+		source->Fill(Voxel::NONE);
+		return false;
+	case SOLID:
+		source->Fill(Voxel::STONE);
+		return true;
+	default:
+		break;
+	}
+
+	/* Density of the caves is needed only if some voxel of the chunk is within the cave depth. Buffer is reused by all chunks generated on this thread. */
+	static thread_local std::vector<float> caveDensity;
+	const float* caves = nullptr;
+	if (HasCaves() && (int)offset.y + size - 1 >= heightMap.minHeight - _caveDepth) {
+		caveDensity.resize(size * size * size);
+		NoiseLattice::Fill(GetNoise(), (int)offset.x, (int)offset.y + caveShift, (int)offset.z, _caveScale, size, caveDensity.data());
+		caves = caveDensity.data();
 	}
 
 	/* Now, for each voxel in the chunk we must check: */
 	for (int z = 0; z < size; ++z) {
 		for (int x = 0; x < size; ++x) {
-			int height = heightMap[z][x];
+			int height = heightMap.heights[x + size * z];
+			uint64_t columnHash = GetColumnHash(x + (int)offset.x, z + (int)offset.z);
 
 			for (int y = 0; y < size; ++y) {
 				int index = x + size * (y + z * size);
-				/* Generate rock level from normal distribution */
-				int rocks = (int)_distribution(_generator);
+				/* Get rock level from normal distribution hashed from the voxel position */
+				int rocks = (int)GetRockDepth(columnHash, y + (int)offset.y);
 
 				/* Calculate height of the chunk in world coordinates */
 				int chunkHeight = y + (int)offset.y;
 
+				/* Voxels of the caves are air like the ones above the surface */
+				bool carved = caves != nullptr && IsCave(chunkHeight, height, caves[index]);
+
 				/* And similar like for single voxel: if below air level */
-				if (chunkHeight < height) {
+				if (chunkHeight < height && !carved) {
 					/* And if below rock level draw stone */
 					if (chunkHeight < height - 1 - rocks)
 						source->SetLocal(x, y, z, Voxel::STONE);
@@ -144,8 +190,87 @@ TerrainGenerator::GetChunk(Chunk* source)
 		}
 	}
 
+	/* Shrink palette of the chunk to the types that were really used */
+	source->Compact();
+
 	/* If there were no voxels added, we want to indicate that */
 	return (added != 0);
 }
 
-}
\ No newline at end of file
+TerrainGenerator::ChunkType
+TerrainGenerator::ClassifyChunk(const Vector3& offset) const
+{
+	HeightMapCache::HeightMap heightMap;
+	GetHeightMap((int)offset.x, (int)offset.z, &heightMap);
+	return ClassifyChunk((int)offset.y, heightMap);
+}
+
+TerrainGenerator::ChunkType
+TerrainGenerator::ClassifyChunk(int bottom, const HeightMapCache::HeightMap& heightMap) const
+{
+	/* Voxels at or above the height are air, voxels below the rock level and caves of the lowest column are stone */
+	int solidBelow = heightMap.minHeight - 1 - GetMaxRocks();
+	if (HasCaves())
+		solidBelow = std::min(solidBelow, heightMap.minHeight - _caveDepth);
+
+	if (bottom >= heightMap.maxHeight)
+		return EMPTY;
+	if (bottom + Chunk::dimension - 1 < solidBelow)
+		return SOLID;
+	return SURFACE;
+}
+
+int
+TerrainGenerator::GetMaxRocks() const
+{
+	return (int)std::ceil(_rockOffset + _maxRockDeviation * _rockSharpness);
+}
+
+float
+TerrainGenerator::GetCaveDensity(int x, int y, int z) const
+{
+	return NoiseLattice::GetValue(GetNoise(), x, y + caveShift, z, _caveScale);
+}
+
+void
+TerrainGenerator::GetHeightMap(int x, int z, HeightMapCache::HeightMap* heightMap) const
+{
+	/* Noise is computed outside the cache lock, so other threads are not waiting for it */
+	if (_heightMaps.Find(x, z, heightMap))
+		return;
+
+	ComputeHeightMap(x, z, heightMap);
+	_heightMaps.Insert(x, z, *heightMap);
+}
+
+void
+TerrainGenerator::ComputeHeightMap(int x, int z, HeightMapCache::HeightMap* heightMap) const
+{
+	const int size = Chunk::dimension;
+
+	if (!_shape.IsEmpty()) {
+		float values[size * size];
+		_shape.Fill(GetNoise(), (float)x, (float)z, size, size, values);
+		for (int i = 0; i < size * size; ++i)
+			heightMap->heights[i] = (int)(values[i] * _spread + _seaOffset);
+		heightMap->UpdateRange();
+		return;
+	}
+
+	/* Noise is computed for whole planes at once */
+	float heights[size * size];
+	float roughs[size * size];
+	float details[size * size];
+	const Noise& noise = GetNoise();
+	noise.FillGrid2D((float)x, (float)z, heightPlane, _smoothness, size, size, heights);
+	noise.FillGrid2D((float)x, (float)z, roughPlane, _smoothness, size, size, roughs);
+	noise.FillGrid2D((float)x, (float)z, detailPlane, _details, size, size, details);
+
+	for (int i = 0; i < size * size; ++i) {
+		float height = (heights[i] + (roughs[i] * details[i])) * _spread + _seaOffset;
+		heightMap->heights[i] = (int)height;
+	}
+	heightMap->UpdateRange();
+}
+
+}
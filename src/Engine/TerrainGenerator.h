@@ -1,15 +1,41 @@
 #pragma once
 
+#include "HeightMapCache.h"
+#include "Math/NoiseGraph.h"
+#include "Math/NoiseLattice.h"
 #include "Math/PerlinNoise.h"
+#include "Math/SimplexNoise.h"
+#include "Math/MathFunctions.h"
 #include "Resources/Voxels/Voxel.h"
 #include "Resources/Voxels/Chunk.h"
 
+#include <vector>
+
 namespace vengine {
 
-/* Class for generating terrain with given properties using Perlin noise*/
+/*
+* Class for generating terrain with given properties using Perlin noise.
+* Random values are hashed from the world seed and position of the voxel, so generated chunk does not depend
+* on the order of generation and many chunks can be generated at once from different threads.
+* Heights of the chunk columns are cached, so chunks stacked on one column compute noise only once.
+* Changing settings of the terrain clears the cache.
+*/
 class TerrainGenerator
 {
 public:
+	/* How the chunk lies against the terrain surface */
+	enum ChunkType {
+		EMPTY,		/* Whole chunk is above the terrain */
+		SOLID,		/* Whole chunk is below the deepest rocks, so it is filled with stone */
+		SURFACE		/* Chunk crosses the surface or rock level, its voxels must be generated one by one */
+	};
+
+	/* Backend of the noise used for the terrain shape */
+	enum NoiseType {
+		PERLIN,		/* Slices of 3D Perlin noise, the default one */
+		SIMPLEX		/* True 2D simplex noise, sampling 3 corners instead of 8, but giving different worlds */
+	};
+
 	/* Uses default seed 518331203u and values for smooth terrain */
 	TerrainGenerator();
 	/* Construct object with given seed */
@@ -37,28 +63,85 @@ public:
 	void SetDetails(float details);
 	/* Set how terrain will differ in height */
 	void SetSpread(float spread);
+	/*
+	* Set shape of the terrain made of noise layers. Height is value of the shape multiplied by spread, above the sea offset.
+	* With empty shape the default hills are generated, controlled by smoothness and details.
+	*/
+	void SetShape(const NoiseGraph& shape);
+	const NoiseGraph& GetShape() const;
+	/* Set noise backend, worlds generated with different backends are different */
+	void SetNoiseType(NoiseType type);
+	NoiseType GetNoiseType() const;
+	/*
+	* Carve caves below the surface with 3D noise of given scale. Voxels down to given depth below the surface become air
+	* where the noise is above the threshold, caves reaching the surface give overhangs and arches. Noise is sampled
+	* every NoiseLattice::step voxels and interpolated, so caves cost a fraction of per-voxel noise. Depth 0 disables caves.
+	*/
+	void SetCaves(float scale, float threshold, int depth);
+	bool HasCaves() const;
+	/* Get density of the caves at given voxel, voxel within the cave depth is air if it is above the threshold */
+	float GetCaveDensity(int x, int y, int z) const;
 
 	/* Get voxel with given coords */
-	Voxel GetVoxel(int x, int y, int z);
+	Voxel GetVoxel(int x, int y, int z) const;
 
-	/* Fill chunk with values from generator and return true if generated chunk is not empty */
-	bool GetChunk(Chunk* source);
+	/*
+	* Fill chunk with values from generator and return true if generated chunk is not empty.
+	* Empty and solid chunks are filled at once and become uniform, only surface chunks are generated voxel by voxel.
+	*/
+	bool GetChunk(Chunk* source) const;
+	/* Check how the chunk at given offset lies against the terrain, using only height map of its column */
+	ChunkType ClassifyChunk(const Vector3& offset) const;
+	/*
+	* Get how deep below the surface rocks appear at given voxel. Depth has approximately normal distribution with mean
+	* of the rock offset and deviation of the rock sharpness, and it depends only on the seed and position of the voxel.
+	*/
+	float GetRockDepth(int x, int y, int z) const;
+
+	/*
+	* Get heights of the chunk column starting at given world coordinates, together with the lowest and highest one.
+	* Chunk of the column above maxHeight is empty and chunk below minHeight is solid.
+	*/
+	void GetHeightMap(int x, int z, HeightMapCache::HeightMap* heightMap) const;
+	/* Get cache of the height maps, used to check its stats or change its size */
+	HeightMapCache& GetHeightMapCache();
 
 private:
 	static const float _baseDetails; /* Details given by user will be divided by this value */
+	static const float _maxRockDeviation; /* Rocks are never deeper than this many deviations below offset */
+
+	/* Get hash of the seed and column position, shared by all voxels of the column */
+	uint64_t GetColumnHash(int x, int z) const;
+	/* Get depth of the rocks at given height of the column */
+	float GetRockDepth(uint64_t columnHash, int y) const;
+	/* Check how the chunk starting at given height lies against the terrain of its column */
+	ChunkType ClassifyChunk(int bottom, const HeightMapCache::HeightMap& heightMap) const;
+	/* Get the deepest rock level, so chunk below it is solid without drawing rocks */
+	int GetMaxRocks() const;
+	/* Check if voxel at given height of the column with given surface height is carved by the cave */
+	bool IsCave(int y, int height, float density) const;
+	/* Compute heights of the chunk column from noise, without the cache */
+	void ComputeHeightMap(int x, int z, HeightMapCache::HeightMap* heightMap) const;
+	/* Get generator of the selected noise backend */
+	const Noise& GetNoise() const;
 
 	PerlinNoise _perlinGenerator; /* Perlin noise generator */
+	SimplexNoise _simplexGenerator;	/* Simplex noise generator */
+	NoiseType _noiseType;	/* Backend used for the terrain shape */
 	int _seaOffset;			/* Offset from the sea level */
 	float _spread;			/* Diversity in high of the terrain */
 	float _rockOffset;		/* How deep rocks will appear below dirt */
 	float _rockSharpness;	/* The higher value, the rocks will be spread more randomly near offset */
 	float _details;			/* Local details of the terrain, it is detail given by user divided by _baseDetails */
 	float _smoothness;		/* Smoothness of the terrain in global scale */
+	NoiseGraph _shape;		/* Layers of the terrain shape, default hills are used if it is empty */
+	float _caveScale;		/* Size of the cave noise in voxels */
+	float _caveThreshold;	/* Density above which voxels are carved */
+	int _caveDepth;			/* How deep below the surface caves are carved, 0 if there are no caves */
 
 	unsigned int _seed;		/* Seed for the generators */
 
-	std::default_random_engine _generator;			/* Generator used for rocks distribution */
-	std::normal_distribution<float> _distribution;	/* Normal distribution of the rocks */
+	mutable HeightMapCache _heightMaps;	/* Heights of the recently generated chunk columns */
 };
 
 
@@ -67,27 +150,27 @@ TerrainGenerator::SetSeed(unsigned int seed)
 {
 	_seed = seed;
 	_perlinGenerator.SetSeed(_seed);
-	_generator.seed(_seed);
+	_simplexGenerator.SetSeed(_seed);
+	_heightMaps.Clear();
 }
 
 inline void
 TerrainGenerator::SetSeaOffset(int offset)
 {
 	_seaOffset = offset;
+	_heightMaps.Clear();
 }
 
 inline void
 TerrainGenerator::SetRockOffset(float offset)
 {
 	_rockOffset = offset;
-	_distribution = std::normal_distribution<float>(_rockOffset, _rockSharpness);
 }
 
 inline void
 TerrainGenerator::SetRockSharpness(float rockSharpness)
 {
 	_rockSharpness = rockSharpness;
-	_distribution = std::normal_distribution<float>(_rockOffset, _rockSharpness);
 }
 
 
@@ -95,6 +178,7 @@ inline void
 TerrainGenerator::SetSmoothness(float smoothness)
 {
 	_smoothness = smoothness;
+	_heightMaps.Clear();
 }
 
 
@@ -102,12 +186,92 @@ inline void
 TerrainGenerator::SetDetails(float details)
 {
 	_details = _baseDetails/details;
+	_heightMaps.Clear();
 }
 
 inline void 
 TerrainGenerator::SetSpread(float spread)
 {
 	_spread = spread;
+	_heightMaps.Clear();
+}
+
+inline void
+TerrainGenerator::SetShape(const NoiseGraph& shape)
+{
+	_shape = shape;
+	_heightMaps.Clear();
+}
+
+inline const NoiseGraph&
+TerrainGenerator::GetShape() const
+{
+	return _shape;
+}
+
+inline void
+TerrainGenerator::SetNoiseType(NoiseType type)
+{
+	_noiseType = type;
+	_heightMaps.Clear();
+}
+
+inline TerrainGenerator::NoiseType
+TerrainGenerator::GetNoiseType() const
+{
+	return _noiseType;
+}
+
+inline const Noise&
+TerrainGenerator::GetNoise() const
+{
+	if (_noiseType == SIMPLEX)
+		return _simplexGenerator;
+	return _perlinGenerator;
+}
+
+inline void
+TerrainGenerator::SetCaves(float scale, float threshold, int depth)
+{
+	_caveScale = scale;
+	_caveThreshold = threshold;
+	_caveDepth = depth;
+}
+
+inline bool
+TerrainGenerator::HasCaves() const
+{
+	return _caveDepth > 0;
+}
+
+inline bool
+TerrainGenerator::IsCave(int y, int height, float density) const
+{
+	return y >= height - _caveDepth && density > _caveThreshold;
+}
+
+inline float
+TerrainGenerator::GetRockDepth(int x, int y, int z) const
+{
+	return GetRockDepth(GetColumnHash(x, z), y);
+}
+
+inline uint64_t
+TerrainGenerator::GetColumnHash(int x, int z) const
+{
+	return hashCombine(hashCombine((uint64_t)_seed, (uint64_t)(int64_t)x), (uint64_t)(int64_t)z);
+}
+
+inline float
+TerrainGenerator::GetRockDepth(uint64_t columnHash, int y) const
+{
+	return _rockOffset + _rockSharpness * hashToNormal(hashMix(hashCombine(columnHash, (uint64_t)(int64_t)y)));
+}
+
+inline HeightMapCache&
+TerrainGenerator::GetHeightMapCache()
+{
+	return _heightMaps;
 }
 
 }
\ No newline at end of file
@@ -76,6 +76,17 @@ int
 VEngine::InitLocalResources()
 {
 	_renderer.Init();
+
+	/*
+	* Main thread is uploading meshes and running the game, rest of the cores is shared by meshing and streaming,
+	* so both pools together are not running more threads than there are cores. Each pool needs at least one thread.
+	* Streaming is needed only while travelling, so it gets about a third of them.
+	*/
+	_backgroundThreads = std::max(2, (int)std::thread::hardware_concurrency() - 1);
+	_streamThreads = std::max(1, _backgroundThreads / 3);
+	_meshWorkers.Start(_backgroundThreads - _streamThreads);
+	Octree::SetMeshWorkers(&_meshWorkers);
+	Octree::SetMeshCache(&_meshCache);
 #ifdef VE_DEBUG
 	_menuGui = new Canvas(Vector4(0.0f, 0.0f, 0.0f, 0.7f));
 	GameObject::debugConfig = &_debugConfig;
@@ -466,22 +477,24 @@ VEngine::LoadWorld()
 	EnemyHead* eHead = (EnemyHead *)(enemyObject->GetChild());
 	eHead->SetPlayer(player);
 
-	/* Generate terrain */
-	TerrainGenerator terrainGen(0, 5, 1);
-	terrainGen.SetSmoothness(256);
-	terrainGen.SetDetails(1);
-	terrainGen.SetSpread(32);
-	terrainGen.SetSeed(312538u);
-	for (int z = 0; z < 16; ++z) {
-		for (int y = 0; y < 16; ++y) {
-			for (int x = 0; x < 16; ++x) {
-				Chunk* chunk = new Chunk(Vector3((x - 8.0f) * Chunk::dimension, (y - 8.0f) * Chunk::dimension, (z - 8.0f) * Chunk::dimension));
-				if(terrainGen.GetChunk(chunk))
-					_octree.Add(chunk);
-			}
-		}
-	}
-
+	/* Generate terrain around the player, the rest is streamed while the player moves */
+	_terrainGenerator.SetSeaOffset(0);
+	_terrainGenerator.SetRockOffset(5);
+	_terrainGenerator.SetRockSharpness(1);
+	_terrainGenerator.SetSmoothness(256);
+	_terrainGenerator.SetDetails(1);
+	_terrainGenerator.SetSpread(32);
+	_terrainGenerator.SetSeed(312538u);
+	_worldStreamer.SetGenerator(&_terrainGenerator);
+	_worldStreamer.SetOctree(&_octree);
+
+	/*
+	* Nothing is meshed before the world is loaded, so the streamer can use all background threads for loading.
+	* Then only its part of the threads split when mesh workers were started can work at once.
+	*/
+	_worldStreamer.Start(_backgroundThreads);
+	_worldStreamer.Load(transformPlayer.GetPosition());
+	_worldStreamer.SetMaxWorkingThreads(_streamThreads);
 
 #ifdef VE_DEBUG
 	/* Add GUI */
@@ -499,7 +512,6 @@ VEngine::LoadWorld()
 	/* Initialize Octree */
 	_octree.Add(player);
 	_octree.Add(enemyObject);
-	_octree.SetBoundingArea(BoundingBox(Vector3::zeroes, Vector3(16.0f * Chunk::dimension)));
 }
 
 void
@@ -513,8 +525,11 @@ VEngine::Destroy()
 void
 VEngine::DestroyWorld()
 {
+	_worldStreamer.Stop();
+	_meshWorkers.Stop();
 	delete _menuGui;
 	delete _world;
+	VoxelMesh::DeleteQuadIndices();
 }
 
 void
@@ -583,6 +598,7 @@ VEngine::Run()
 
 		_world->Update();
 		_world->Physic();
+		_worldStreamer.Update(_renderer.GetActiveCamera()->GetPosition(), _renderer.GetActiveCamera()->GetDirection());
 		_octree.UpdateTree();
 		_octree.Update();
 		
@@ -615,7 +631,9 @@ VEngine::Run()
 
 #ifdef VE_DEBUG
 		/* Fps and position in console */
-		std::cout << "\rFPS: " << 1.0f / Time::DeltaTime() << "\tPosition:" << _renderer.GetActiveCamera()->GetPosition();
+		std::cout << "\rFPS: " << 1.0f / Time::DeltaTime() << "\tPosition:" << _renderer.GetActiveCamera()->GetPosition()
+				  << "\tMesh cache hits: " << 100.0 * _meshCache.GetHitRate() << "%"
+				  << "\tChunks: " << _worldStreamer.GetResidentCount();
 #endif
 
 		/* If ESC is pressed, close */
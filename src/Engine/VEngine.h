@@ -37,6 +37,7 @@
 #include "Octree.h"
 #include "DebugConfig.h"
 #include "TerrainGenerator.h"
+#include "WorldStreamer.h"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -75,7 +76,13 @@ private:
 	Renderer _renderer;		/* Used for rendering objects */
 	std::string _gameTitle;	/* Title of the game */
 	GameObject* _world;		/* This object represents scene - all game objects will be attached to this */
+	MeshWorkers _meshWorkers;	/* Threads generating meshes of the changed chunks, must outlive the octree */
+	MeshCache _meshCache;		/* Meshes shared by chunks with the same contents, must outlive the octree */
+	TerrainGenerator _terrainGenerator;	/* Generator of the chunks, must outlive the world streamer */
 	Octree _octree;			/* Octree used for collision checking and sorting physical objects and chunks */
+	WorldStreamer _worldStreamer;	/* Loads chunks around the player and removes far ones */
+	int _backgroundThreads;	/* Threads besides the main one, all of them generate the world while it is loaded */
+	int _streamThreads;		/* Part of the background threads given to the world streamer, the rest generates meshes */
 	Canvas* _menuGui;		/* Canvas storing GUI for stering debugging options */
 
 #ifdef VE_DEBUG
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Assert.h"
+#include "Math/MathFunctions.h"
+
+#include <stdint.h>
+
+namespace vengine {
+
+/*
+* Packed vertex used by voxel meshes, 8 bytes instead of 64 bytes of the generic Vertex.
+* Position is stored as corner of the voxel grid, normal as side of the voxel and UV as number of tile repeats.
+* World position is restored in the Voxel shader using voxel size and center of the mesh.
+* It is not depending on OpenGL, so vertices can be packed and checked without context.
+*
+* position: x (bits 0-7), y (bits 8-15), z (bits 16-23), side (bits 24-26)
+* texture:  u (bits 0-7), v (bits 8-15), atlas x (bits 16-23), atlas y (bits 24-31)
+*/
+struct VoxelVertex
+{
+	uint32_t position;
+	uint32_t texture;
+
+	/* Highest value of each packed field, so the highest grid coordinate and the longest quad */
+	static const int maxValue = 0xff;
+
+	/* Pack vertex, all values must be in range [0, maxValue] and side must be one of Voxel::Side */
+	static VoxelVertex Pack(int x, int y, int z, int side, int u, int v, int atlasX, int atlasY);
+	/* Unpack vertex into values given to Pack */
+	void Unpack(int* x, int* y, int* z, int* side, int* u, int* v, int* atlasX, int* atlasY) const;
+
+	/*
+	* Fill indices of given number of quads starting from quad 'first'. Every quad is made of 4 following vertices
+	* and all quads are using the same pattern, so one index buffer can be shared by all voxel meshes.
+	*/
+	static void FillQuadIndices(uint32_t* indices, uint32_t first, uint32_t quadsNumber);
+
+	bool operator==(const VoxelVertex& other) const;
+	bool operator!=(const VoxelVertex& other) const;
+};
+
+inline VoxelVertex
+VoxelVertex::Pack(int x, int y, int z, int side, int u, int v, int atlasX, int atlasY)
+{
+	assert(between(x, 0, maxValue) && between(y, 0, maxValue) && between(z, 0, maxValue), "Position out of range: %d %d %d.", x, y, z);
+	assert(between(side, 0, 5), "Wrong side: %d.", side);
+	assert(between(u, 0, maxValue) && between(v, 0, maxValue), "UV out of range: %d %d.", u, v);
+	assert(between(atlasX, 0, maxValue) && between(atlasY, 0, maxValue), "Atlas offset out of range: %d %d.", atlasX, atlasY);
+
+	VoxelVertex vertex;
+	vertex.position = (uint32_t)x | ((uint32_t)y << 8) | ((uint32_t)z << 16) | ((uint32_t)side << 24);
+	vertex.texture = (uint32_t)u | ((uint32_t)v << 8) | ((uint32_t)atlasX << 16) | ((uint32_t)atlasY << 24);
+	return vertex;
+}
+
+inline void
+VoxelVertex::Unpack(int* x, int* y, int* z, int* side, int* u, int* v, int* atlasX, int* atlasY) const
+{
+	*x = position & 0xff;
+	*y = (position >> 8) & 0xff;
+	*z = (position >> 16) & 0xff;
+	*side = (position >> 24) & 0x7;
+	*u = texture & 0xff;
+	*v = (texture >> 8) & 0xff;
+	*atlasX = (texture >> 16) & 0xff;
+	*atlasY = (texture >> 24) & 0xff;
+}
+
+inline void
+VoxelVertex::FillQuadIndices(uint32_t* indices, uint32_t first, uint32_t quadsNumber)
+{
+	/* Two triangles: third, fourth and first corner, then first, second and third */
+	static const uint32_t pattern[6] = { 2, 3, 0, 0, 1, 2 };
+
+	for (uint32_t quad = 0; quad < quadsNumber; ++quad) {
+		uint32_t offset = 4 * (first + quad);
+		for (int i = 0; i < 6; ++i)
+			indices[6 * quad + i] = offset + pattern[i];
+	}
+}
+
+inline bool
+VoxelVertex::operator==(const VoxelVertex& other) const
+{
+	return position == other.position && texture == other.texture;
+}
+
+inline bool
+VoxelVertex::operator!=(const VoxelVertex& other) const
+{
+	return !(*this == other);
+}
+
+}
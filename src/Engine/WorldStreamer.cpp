@@ -0,0 +1,361 @@
+#include "WorldStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vengine {
+
+WorldStreamer::WorldStreamer() :
+	_generator(nullptr), _octree(nullptr), _radius(8), _verticalRadius(4), _hysteresis(2), _maxChanges(16),
+	_planned(false), _working(0), _maxWorking(0), _loading(false), _stop(false)
+{
+	_center.x = 0;
+	_center.y = 0;
+	_center.z = 0;
+}
+
+WorldStreamer::~WorldStreamer()
+{
+	Stop();
+
+	for (size_t i = 0; i < _finished.size(); ++i)
+		delete _finished[i].chunk;
+}
+
+void
+WorldStreamer::Start(int threadsNumber)
+{
+	assert(_threads.empty(), "World streamer is already started.");
+
+	for (int i = 0; i < threadsNumber; ++i)
+		_threads.push_back(std::thread(&WorldStreamer::Work, this));
+}
+
+void
+WorldStreamer::SetMaxWorkingThreads(int threadsNumber)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_maxWorking = threadsNumber;
+	}
+	_jobReady.notify_all();
+}
+
+void
+WorldStreamer::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_jobReady.notify_all();
+
+	for (size_t i = 0; i < _threads.size(); ++i)
+		_threads[i].join();
+	_threads.clear();
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (size_t i = 0; i < _jobs.size(); ++i)
+		_requested.erase(_jobs[i]);
+	_jobs.clear();
+	_stop = false;
+}
+
+void
+WorldStreamer::Load(const Vector3& position)
+{
+	assert(_generator != nullptr && _octree != nullptr, "World streamer needs generator and octree.");
+
+	Key center = GetKey(position);
+
+	/* Root must be chunk dimension multiplied by power of two, so its leaves are matching the chunks */
+	int size = 1;
+	while (size < 2 * (std::max(_radius, _verticalRadius) + _hysteresis + 1))
+		size *= 2;
+	_octree->SetBoundingArea(BoundingBox(GetOffset(center), Vector3((float)(size * Chunk::dimension))));
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	/* All missing chunks are given to the threads, jobs planned earlier are dropped like in Plan */
+	for (size_t i = 0; i < _jobs.size(); ++i)
+		_requested.erase(_jobs[i]);
+	_jobs.clear();
+
+	for (int y = -_verticalRadius; y <= _verticalRadius; ++y) {
+		for (int z = -_radius; z <= _radius; ++z) {
+			for (int x = -_radius; x <= _radius; ++x) {
+				Key key = { center.x + x, center.y + y, center.z + z };
+				if (IsInside(key, center, 0) && _resident.find(key) == _resident.end() && _requested.find(key) == _requested.end()) {
+					_jobs.push_back(key);
+					_requested.insert(key);
+				}
+			}
+		}
+	}
+
+	_loading = true;
+	lock.unlock();
+	_jobReady.notify_all();
+	lock.lock();
+
+	/* Calling thread is generating too, so loading works also without threads */
+	while (!_jobs.empty()) {
+		Key key = _jobs.front();
+		_jobs.pop_front();
+
+		lock.unlock();
+		Finished result;
+		result.key = key;
+		result.chunk = Generate(key);
+		lock.lock();
+
+		_finished.push_back(result);
+	}
+	_jobDone.wait(lock, [this] { return _working == 0; });
+	_loading = false;
+
+	std::deque<Finished> finished;
+	finished.swap(_finished);
+	for (size_t i = 0; i < finished.size(); ++i)
+		_requested.erase(finished[i].key);
+	lock.unlock();
+
+	_center = center;
+	for (size_t i = 0; i < finished.size(); ++i) {
+		if (!IsInside(finished[i].key, center, _hysteresis)) {
+			delete finished[i].chunk;
+			continue;
+		}
+
+		_resident.insert(finished[i].key);
+		if (finished[i].chunk != nullptr)
+			_octree->Add(finished[i].chunk);
+	}
+}
+
+void
+WorldStreamer::Update(const Vector3& position, const Vector3& direction)
+{
+	Key center = GetKey(position);
+	bool moved = !_planned || !(center == _center);
+	bool turned = _planned && Vector3::Dot(direction, _direction) < 0.9f;
+
+	if (moved) {
+		_octree->Enclose(GetArea(center));
+		_center = center;
+		RemoveFar(center);
+	}
+
+	/* Order of the chunks depends on the direction of view, so they are sorted again after turning around */
+	if (moved || turned) {
+		Plan(center, direction);
+		_direction = direction;
+		_planned = true;
+	}
+
+	AddFinished();
+
+	/* Player could come back since chunks were marked, so they are checked again */
+	for (int removed = 0; removed < _maxChanges && !_evictions.empty();) {
+		Key key = _evictions.front();
+		_evictions.pop_front();
+
+		if (IsInside(key, _center, _hysteresis) || _resident.find(key) == _resident.end())
+			continue;
+
+		/* Edited chunks stay resident until the world can be saved, otherwise the edits would be lost */
+		Vector3 chunkCenter = GetOffset(key) + (float)Chunk::dimension / 2.0f;
+		Chunk* chunk = _octree->GetChunkAt(chunkCenter);
+		if (chunk != nullptr && chunk->IsEdited())
+			continue;
+
+		_resident.erase(key);
+		if (_octree->RemoveChunk(chunkCenter))
+			++removed;
+	}
+}
+
+size_t
+WorldStreamer::GetPendingCount()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _requested.size();
+}
+
+WorldStreamer::Key
+WorldStreamer::GetKey(const Vector3& position)
+{
+	Key key;
+	key.x = (int)std::floor(position.x / Chunk::dimension);
+	key.y = (int)std::floor(position.y / Chunk::dimension);
+	key.z = (int)std::floor(position.z / Chunk::dimension);
+	return key;
+}
+
+Vector3
+WorldStreamer::GetOffset(const Key& key)
+{
+	return Vector3((float)(key.x * Chunk::dimension), (float)(key.y * Chunk::dimension), (float)(key.z * Chunk::dimension));
+}
+
+bool
+WorldStreamer::IsInside(const Key& key, const Key& center, int extension) const
+{
+	int x = key.x - center.x;
+	int y = key.y - center.y;
+	int z = key.z - center.z;
+	int radius = _radius + extension;
+
+	return x * x + z * z <= radius * radius && std::abs(y) <= _verticalRadius + extension;
+}
+
+BoundingBox
+WorldStreamer::GetArea(const Key& center) const
+{
+	/* All chunks which are not removed yet must fit into the octree */
+	int horizontal = 2 * (_radius + _hysteresis) + 1;
+	int vertical = 2 * (_verticalRadius + _hysteresis) + 1;
+
+	Vector3 position = GetOffset(center) + (float)Chunk::dimension / 2.0f;
+	return BoundingBox(position, Vector3((float)horizontal, (float)vertical, (float)horizontal) * (float)Chunk::dimension);
+}
+
+void
+WorldStreamer::Plan(const Key& center, const Vector3& direction)
+{
+	struct Candidate {
+		Key key;
+		float priority;
+	};
+
+	std::vector<Candidate> candidates;
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	/* Jobs planned for the previous position are dropped, chunks being generated are kept */
+	for (size_t i = 0; i < _jobs.size(); ++i)
+		_requested.erase(_jobs[i]);
+	_jobs.clear();
+
+	for (int y = -_verticalRadius; y <= _verticalRadius; ++y) {
+		for (int z = -_radius; z <= _radius; ++z) {
+			for (int x = -_radius; x <= _radius; ++x) {
+				Key key = { center.x + x, center.y + y, center.z + z };
+				if (!IsInside(key, center, 0) || _resident.find(key) != _resident.end() || _requested.find(key) != _requested.end())
+					continue;
+
+				/* Chunks behind the camera are treated as if they were twice as far */
+				float distance = std::sqrt((float)(x * x + y * y + z * z));
+				float facing = distance > 0.0f ? (x * direction.x + y * direction.y + z * direction.z) / distance : 1.0f;
+
+				Candidate candidate;
+				candidate.key = key;
+				candidate.priority = distance * (1.5f - 0.5f * facing);
+				candidates.push_back(candidate);
+			}
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.priority < b.priority; });
+
+	for (size_t i = 0; i < candidates.size(); ++i) {
+		_jobs.push_back(candidates[i].key);
+		_requested.insert(candidates[i].key);
+	}
+
+	lock.unlock();
+	_jobReady.notify_all();
+}
+
+void
+WorldStreamer::AddFinished()
+{
+	std::vector<Finished> finished;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		/* Without threads chunks are generated here, as many as can be added in one frame */
+		if (_threads.empty()) {
+			for (int i = 0; i < _maxChanges && !_jobs.empty(); ++i) {
+				Finished result;
+				result.key = _jobs.front();
+				result.chunk = Generate(result.key);
+				_jobs.pop_front();
+				_finished.push_back(result);
+			}
+		}
+
+		for (int i = 0; i < _maxChanges && !_finished.empty(); ++i) {
+			finished.push_back(_finished.front());
+			_requested.erase(_finished.front().key);
+			_finished.pop_front();
+		}
+	}
+
+	for (size_t i = 0; i < finished.size(); ++i) {
+		/* Player could go away while chunk was generated */
+		if (!IsInside(finished[i].key, _center, _hysteresis)) {
+			delete finished[i].chunk;
+			continue;
+		}
+
+		_resident.insert(finished[i].key);
+		if (finished[i].chunk != nullptr)
+			_octree->Add(finished[i].chunk);
+	}
+}
+
+void
+WorldStreamer::RemoveFar(const Key& center)
+{
+	_evictions.clear();
+	for (std::unordered_set<Key, KeyHash>::const_iterator it = _resident.begin(); it != _resident.end(); ++it)
+		if (!IsInside(*it, center, _hysteresis))
+			_evictions.push_back(*it);
+}
+
+Chunk*
+WorldStreamer::Generate(const Key& key) const
+{
+	Chunk* chunk = new Chunk(GetOffset(key));
+	if (_generator->GetChunk(chunk))
+		return chunk;
+
+	delete chunk;
+	return nullptr;
+}
+
+bool
+WorldStreamer::CanWork() const
+{
+	return _loading || _maxWorking <= 0 || _working < _maxWorking;
+}
+
+void
+WorldStreamer::Work()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (true) {
+		_jobReady.wait(lock, [this] { return _stop || (!_jobs.empty() && CanWork()); });
+		if (_stop)
+			return;
+
+		Key key = _jobs.front();
+		_jobs.pop_front();
+
+		/* Generator is only read, so chunks are generated without the lock */
+		++_working;
+		lock.unlock();
+		Finished result;
+		result.key = key;
+		result.chunk = Generate(key);
+		lock.lock();
+		--_working;
+
+		_finished.push_back(result);
+		_jobDone.notify_all();
+	}
+}
+
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "Octree.h"
+#include "TerrainGenerator.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace vengine {
+
+/*
+* Keeps chunks around the player resident in the octree, so the world has no borders.
+* Missing chunks are generated by background threads, starting with the closest ones in front of the camera.
+* Finished chunks are added to the octree and far chunks are removed with limited number per frame, so frame time
+* does not depend on the speed of travelling. Chunks are removed only when they are farther than the radius extended
+* by the hysteresis, so chunks on the border are not loaded and removed again when the player moves back and forth.
+* Octree root is resized to contain resident area, so the tree stays shallow wherever the player goes.
+* Chunks edited by the player are never removed, because there is no way to save them yet.
+* The same threads generate the whole area at once when the world is loaded.
+*/
+class WorldStreamer {
+public:
+	WorldStreamer();
+	/* Stops threads and deletes chunks which have not been added to the octree */
+	~WorldStreamer();
+
+	/* Set generator of the chunks, it must outlive the streamer and must not be changed while threads are running */
+	void SetGenerator(const TerrainGenerator* generator);
+	/* Set octree storing resident chunks */
+	void SetOctree(Octree* octree);
+
+	/* Set radius of the resident area in chunks, horizontally and vertically */
+	void SetRadius(int horizontal, int vertical);
+	/* Set how many chunks farther than radius chunks must be to be removed */
+	void SetHysteresis(int chunks);
+	/* Set how many chunks can be added to the octree and how many removed in one frame */
+	void SetMaxChangesPerFrame(int changes);
+
+	/* Start given number of threads. With 0 threads chunks are generated during Update, within the limit of changes. */
+	void Start(int threadsNumber);
+	/*
+	* Set how many threads can generate chunks at the same time during updates, 0 allows all of them.
+	* Other threads are waiting, so their cores can be used by other work. Load is always using all threads.
+	*/
+	void SetMaxWorkingThreads(int threadsNumber);
+	/* Stop all threads after they finish current chunks. Pending chunks are dropped. */
+	void Stop();
+
+	/*
+	* Generate all chunks within radius around given position at once and add them to the octree. Calling thread
+	* generates chunks together with all started threads. Used before the first frame, octree area is set around the position.
+	*/
+	void Load(const Vector3& position);
+	/*
+	* Schedule missing chunks around given position, add finished ones to the octree and remove far ones.
+	* Chunks in the direction of view are generated first. It must be called before updating the octree.
+	*/
+	void Update(const Vector3& position, const Vector3& direction);
+
+	/* Get number of chunk positions which are generated, including empty ones which are not stored in the octree */
+	size_t GetResidentCount() const;
+	/* Check if chunk containing given position is generated, it is not stored in the octree if it is empty */
+	bool IsResident(const Vector3& position) const;
+	/* Get number of chunks waiting for generation or being generated */
+	size_t GetPendingCount();
+
+private:
+	/* Position of the chunk in chunks */
+	struct Key {
+		int x;
+		int y;
+		int z;
+
+		bool operator==(const Key& other) const;
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key& key) const;
+	};
+
+	struct Finished {
+		Key key;
+		Chunk* chunk;	/* Generated chunk, nullptr if it is empty */
+	};
+
+	const TerrainGenerator* _generator;
+	Octree* _octree;
+
+	int _radius;			/* Horizontal radius in chunks */
+	int _verticalRadius;	/* Vertical radius in chunks */
+	int _hysteresis;
+	int _maxChanges;
+
+	std::unordered_set<Key, KeyHash> _resident;		/* Generated chunks, used only by the main thread */
+	std::deque<Key> _evictions;		/* Resident chunks which were too far when the player moved last time */
+	Key _center;			/* Chunk with the player during last planning */
+	Vector3 _direction;		/* Direction of view during last planning */
+	bool _planned;			/* Indicates that generation was planned at least once */
+
+	std::vector<std::thread> _threads;
+	std::mutex _mutex;
+	std::condition_variable _jobReady;	/* Notified when jobs are planned, limit of working threads changes or threads are stopping */
+	std::condition_variable _jobDone;	/* Notified when chunk is generated */
+	std::deque<Key> _jobs;				/* Chunks waiting for generation, the most important first */
+	std::unordered_set<Key, KeyHash> _requested;	/* Chunks in jobs, being generated or finished but not taken yet */
+	std::deque<Finished> _finished;		/* Generated chunks waiting for Update */
+	int _working;			/* Number of threads generating chunks right now */
+	int _maxWorking;		/* Limit of working threads during updates, 0 if there is none */
+	bool _loading;			/* Load is waiting for the chunks, so the limit is not used */
+	bool _stop;
+
+	/* Get chunk containing given position */
+	static Key GetKey(const Vector3& position);
+	/* Get offset of the chunk in world coordinates */
+	static Vector3 GetOffset(const Key& key);
+	/* Check if chunk is within radius around center extended by given number of chunks */
+	bool IsInside(const Key& key, const Key& center, int extension) const;
+	/* Get area which must be covered by the octree around the center */
+	BoundingBox GetArea(const Key& center) const;
+
+	/* Sort missing chunks by importance and replace jobs with them */
+	void Plan(const Key& center, const Vector3& direction);
+	/* Add finished chunks to the octree, without threads chunks are generated here */
+	void AddFinished();
+	/* Remove resident chunks which are too far from the center */
+	void RemoveFar(const Key& center);
+
+	/* Generate chunk at given position, returns nullptr if it is empty */
+	Chunk* Generate(const Key& key) const;
+	/* Check if another thread can start generating. Mutex must be locked. */
+	bool CanWork() const;
+	/* Thread routine */
+	void Work();
+};
+
+inline bool
+WorldStreamer::Key::operator==(const Key& other) const
+{
+	return x == other.x && y == other.y && z == other.z;
+}
+
+inline size_t
+WorldStreamer::KeyHash::operator()(const Key& key) const
+{
+	return (size_t)hashCombine(hashCombine((uint64_t)(int64_t)key.x, (uint64_t)(int64_t)key.y), (uint64_t)(int64_t)key.z);
+}
+
+inline void
+WorldStreamer::SetGenerator(const TerrainGenerator* generator)
+{
+	_generator = generator;
+}
+
+inline void
+WorldStreamer::SetOctree(Octree* octree)
+{
+	_octree = octree;
+}
+
+inline void
+WorldStreamer::SetRadius(int horizontal, int vertical)
+{
+	_radius = horizontal;
+	_verticalRadius = vertical;
+}
+
+inline void
+WorldStreamer::SetHysteresis(int chunks)
+{
+	_hysteresis = chunks;
+}
+
+inline void
+WorldStreamer::SetMaxChangesPerFrame(int changes)
+{
+	_maxChanges = changes;
+}
+
+inline size_t
+WorldStreamer::GetResidentCount() const
+{
+	return _resident.size();
+}
+
+inline bool
+WorldStreamer::IsResident(const Vector3& position) const
+{
+	return _resident.find(GetKey(position)) != _resident.end();
+}
+
+}
@@ -2,6 +2,11 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 
 #define between(val, floor, ceil) ((val) >= (floor) && (val) <= (ceil))
@@ -39,3 +44,90 @@ inline float clamp(float value, float floor, float ceiling)
 {
 	return value < floor ? floor : value > ceiling ? ceiling : value;
 }
+
+/**
+*	Finds index of the lowest set bit.
+*	@param value value to be scanned, it cannot be 0.
+*	@return Index of the lowest set bit.
+*/
+inline int bitScanForward(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return (int)index;
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long)value))
+		return (int)index;
+	_BitScanForward(&index, (unsigned long)(value >> 32));
+	return (int)index + 32;
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+/**
+*	Finds index of the highest set bit.
+*	@param value value to be scanned, it cannot be 0.
+*	@return Index of the highest set bit.
+*/
+inline int bitScanReverse(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return (int)index;
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanReverse(&index, (unsigned long)(value >> 32)))
+		return (int)index + 32;
+	_BitScanReverse(&index, (unsigned long)value);
+	return (int)index;
+#else
+	return 63 - __builtin_clzll(value);
+#endif
+}
+
+/**
+*	Mixes value into the hash. Used for hashing contents of the chunks, it is fast and deterministic,
+*	but not cryptographic.
+*	@param hash hash of the previous values.
+*	@param value value to be added.
+*	@return New hash.
+*/
+inline uint64_t hashCombine(uint64_t hash, uint64_t value)
+{
+	hash ^= value * 0x9e3779b97f4a7c15ull;
+	hash = (hash << 31) | (hash >> 33);
+	return hash * 0xbf58476d1ce4e5b9ull;
+}
+
+/**
+*	Mixes all bits of the hash, so every bit of the result depends on every bit of the input.
+*	Used before taking random values from the hash combined with hashCombine.
+*	@param hash hash to be mixed.
+*	@return Mixed hash.
+*/
+inline uint64_t hashMix(uint64_t hash)
+{
+	hash ^= hash >> 30;
+	hash *= 0xbf58476d1ce4e5b9ull;
+	hash ^= hash >> 27;
+	hash *= 0x94d049bb133111ebull;
+	return hash ^ (hash >> 31);
+}
+
+/**
+*	Turns mixed hash into value with approximately standard normal distribution.
+*	It is sum of four uniform values taken from 16-bit parts of the hash, scaled to mean 0 and variance 1,
+*	so the same hash always gives the same value and no generator state is needed.
+*	Values are limited to range (-2 sqrt(3), 2 sqrt(3)).
+*	@param hash mixed hash, for example from hashMix.
+*	@return Value with approximately standard normal distribution.
+*/
+inline float hashToNormal(uint64_t hash)
+{
+	uint32_t sum = (uint32_t)(hash & 0xffff) + (uint32_t)((hash >> 16) & 0xffff) + (uint32_t)((hash >> 32) & 0xffff) + (uint32_t)(hash >> 48);
+	return ((float)(sum + 2) / 65536.0f - 2.0f) * 1.7320508f;
+}
@@ -0,0 +1,76 @@
+#include "Noise.h"
+#include "NoiseSimd.h"
+
+#include <cstdint>
+#include <utility>
+
+namespace vengine {
+
+#ifdef VE_NOISE_AVX2
+
+static bool
+hasAvx2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	/* FMA and AVX, OS must save AVX registers */
+	__cpuid(info, 1);
+	bool fma = (info[2] & (1 << 12)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!fma || !osxsave || !avx || (_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif
+
+/* SplitMix64 generator, its state is advanced by a constant and the result is mixed */
+static uint64_t
+nextRandom(uint64_t* state)
+{
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+void
+Noise::BuildPermutation(unsigned int seed, int permutation[512])
+{
+	for (int i = 0; i < 256; ++i)
+		permutation[i] = i;
+
+	/* Fisher-Yates shuffle, random index is taken from the high bits, so its bias is negligible */
+	uint64_t state = seed;
+	for (int i = 255; i > 0; --i) {
+		int j = (int)(((nextRandom(&state) >> 32) * (uint64_t)(i + 1)) >> 32);
+		std::swap(permutation[i], permutation[j]);
+	}
+
+	for (int i = 0; i < 256; ++i)
+		permutation[256 + i] = permutation[i];
+}
+
+bool
+Noise::IsVectorized()
+{
+#ifdef VE_NOISE_AVX2
+	static const bool avx2 = hasAvx2();
+	return avx2;
+#else
+	return false;
+#endif
+}
+
+}
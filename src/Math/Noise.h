@@ -0,0 +1,47 @@
+#pragma once
+
+namespace vengine {
+
+/*
+* Interface of the gradient noise backends. Terrain is sampled on planes: point (x, y) of the plane identified by z.
+* Backends may sample such plane as a slice of 3D noise or as 2D noise moved by z, so only the values of the same
+* backend are comparable. Grids and points are filled at once, so the virtual call is paid per row, not per sample.
+* Values filled at once must be exactly the same as the ones of GetPlaneNoise on every processor.
+*/
+class Noise
+{
+public:
+	virtual ~Noise() {}
+
+	virtual void SetSeed(unsigned int seed) = 0;
+
+	/* Get noise in range about [-1, 1] at the point of the space */
+	virtual float GetNoise(float x, float y, float z) const = 0;
+	/* Get noise at the point (x, y) of the plane identified by z */
+	virtual float GetPlaneNoise(float x, float y, float z) const = 0;
+
+	/*
+	* Fill countX * countY values of the plane identified by z. Point (i, j) is ((x0 + i) / scale, (y0 + j) / scale)
+	* and its value is stored at index i + countX * j.
+	*/
+	virtual void FillGrid2D(float x0, float y0, float z, float scale, int countX, int countY, float* out) const = 0;
+	/*
+	* Fill countX * countY * countZ values of the box. Point (i, j, k) is ((x0 + i) / scale, (y0 + j) / scale, (z0 + k) / scale)
+	* and its value is stored at index i + countX * (j + countY * k).
+	*/
+	virtual void FillGrid3D(float x0, float y0, float z0, float scale, int countX, int countY, int countZ, float* out) const = 0;
+	/* Fill values of count points lying on the plane identified by z, point i is (x[i], y[i]) */
+	virtual void FillPoints(const float* x, const float* y, float z, int count, float* out) const = 0;
+
+	/* Check if grids are filled with SIMD kernels on this processor */
+	static bool IsVectorized();
+
+protected:
+	/*
+	* Fill permutation with numbers 0-255 shuffled by the seed and repeated twice. Shuffle uses its own generator
+	* instead of the standard library ones, which are different for each compiler, so the worlds are the same everywhere.
+	*/
+	static void BuildPermutation(unsigned int seed, int permutation[512]);
+};
+
+}
@@ -0,0 +1,152 @@
+#include "NoiseGraph.h"
+
+#include "Assert.h"
+#include "MathFunctions.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vengine {
+
+typedef void (*CombineFunction)(const float* planes, int stride, const float* weights, int octaves, int count, float* out);
+
+/*
+* Sum octaves stored in planes with given weights. With Octaves above 0 the number of octaves is known at compile time,
+* so the loop over octaves is unrolled and the loop over points can be vectorized. With 0 octaves argument is used.
+* Ridged octaves are folded to range [0, 1] and the sum is moved back to range [-1, 1].
+*/
+template <int Octaves, bool Ridged>
+static void
+combineOctaves(const float* planes, int stride, const float* weights, int octaves, int count, float* out)
+{
+	const int n = Octaves > 0 ? Octaves : octaves;
+
+	for (int i = 0; i < count; ++i) {
+		float sum = 0.0f;
+		for (int k = 0; k < n; ++k) {
+			float value = planes[k * stride + i];
+			if (Ridged) {
+				value = 1.0f - std::abs(value);
+				value *= value;
+			}
+			sum += weights[k] * value;
+		}
+		out[i] = Ridged ? 2.0f * sum - 1.0f : sum;
+	}
+}
+
+/* Layers with more octaves than specialized are using generic function at index 0 */
+static const int specializedOctaves = 6;
+
+static const CombineFunction combineFunctions[2][specializedOctaves + 1] = {
+	{ combineOctaves<0, false>, combineOctaves<1, false>, combineOctaves<2, false>, combineOctaves<3, false>,
+	  combineOctaves<4, false>, combineOctaves<5, false>, combineOctaves<6, false> },
+	{ combineOctaves<0, true>, combineOctaves<1, true>, combineOctaves<2, true>, combineOctaves<3, true>,
+	  combineOctaves<4, true>, combineOctaves<5, true>, combineOctaves<6, true> }
+};
+
+/* Planes of the noise used by the octaves and warping, chosen between integers, where Perlin noise is not flat */
+static const float octavePlaneStep = 0.17f;
+static const float warpPlaneX = 0.43f;
+static const float warpPlaneZ = 0.71f;
+
+void
+NoiseGraph::AddLayer(const NoiseLayer& layer)
+{
+	assert(between(layer.octaves, 1, maxOctaves), "Wrong number of octaves: %d.", layer.octaves);
+	assert(layer.scale > 0.0f && layer.warpScale > 0.0f, "Scale must be positive: %f %f.", layer.scale, layer.warpScale);
+	assert(layer.curve.size() != 1, "Curve must have at least 2 points.");
+
+	_layers.push_back(layer);
+}
+
+void
+NoiseGraph::Fill(const Noise& noise, float x0, float z0, int countX, int countZ, float* out) const
+{
+	/* Octave planes, warped positions and layer values of one row. Buffer is reused by all fills on this thread. */
+	static thread_local std::vector<float> scratch;
+	scratch.resize((maxOctaves + 5) * countX);
+
+	for (int j = 0; j < countZ; ++j) {
+		float* row = out + countX * j;
+		std::fill(row, row + countX, 0.0f);
+
+		for (size_t i = 0; i < _layers.size(); ++i)
+			AddRow(noise, _layers[i], x0, z0 + j, countX, scratch.data(), row);
+	}
+}
+
+void
+NoiseGraph::AddRow(const Noise& noise, const NoiseLayer& layer, float x0, float z, int count, float* planes, float* out)
+{
+	float* x = planes + maxOctaves * count;
+	float* y = x + count;
+	float* warpX = y + count;
+	float* warpZ = warpX + count;
+	float* values = warpZ + count;
+
+	/* Warped world positions of the points, octaves are sampling noise there */
+	bool warped = layer.warp != 0.0f;
+	if (warped) {
+		noise.FillGrid2D(x0, z, layer.z + warpPlaneX, layer.warpScale, count, 1, warpX);
+		noise.FillGrid2D(x0, z, layer.z + warpPlaneZ, layer.warpScale, count, 1, warpZ);
+		for (int i = 0; i < count; ++i) {
+			warpX[i] = x0 + i + layer.warp * warpX[i];
+			warpZ[i] = z + layer.warp * warpZ[i];
+		}
+	}
+
+	/* Octaves are normalized, so the layer stays in range [-1, 1] for any number of them */
+	float weights[maxOctaves];
+	float total = 0.0f;
+	float amplitude = 1.0f;
+	float scale = layer.scale;
+
+	for (int k = 0; k < layer.octaves; ++k) {
+		float* plane = planes + k * count;
+		float planeZ = layer.z + k * octavePlaneStep;
+
+		if (warped) {
+			for (int i = 0; i < count; ++i) {
+				x[i] = warpX[i] / scale;
+				y[i] = warpZ[i] / scale;
+			}
+			noise.FillPoints(x, y, planeZ, count, plane);
+		}
+		else {
+			noise.FillGrid2D(x0, z, planeZ, scale, count, 1, plane);
+		}
+
+		weights[k] = amplitude;
+		total += amplitude;
+		amplitude *= layer.gain;
+		scale /= layer.lacunarity;
+	}
+
+	for (int k = 0; k < layer.octaves; ++k)
+		weights[k] /= total;
+
+	int function = layer.octaves <= specializedOctaves ? layer.octaves : 0;
+	combineFunctions[layer.type == NoiseLayer::RIDGED][function](planes, count, weights, layer.octaves, count, values);
+
+	if (layer.curve.empty()) {
+		for (int i = 0; i < count; ++i)
+			out[i] += layer.amplitude * values[i];
+	}
+	else {
+		for (int i = 0; i < count; ++i)
+			out[i] += layer.amplitude * Remap(layer.curve, values[i]);
+	}
+}
+
+float
+NoiseGraph::Remap(const std::vector<float>& curve, float value)
+{
+	int last = (int)curve.size() - 1;
+	float t = (clamp(value, -1.0f, 1.0f) + 1.0f) * 0.5f * last;
+	int i = std::min((int)t, last - 1);
+
+	return curve[i] + (t - i) * (curve[i + 1] - curve[i]);
+}
+
+}
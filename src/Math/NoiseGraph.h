@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Noise.h"
+
+#include <vector>
+
+namespace vengine {
+
+/* One layer of the terrain shape - octaves of gradient noise summed with falling amplitudes */
+struct NoiseLayer
+{
+	/* How octaves are turned into the layer value */
+	enum Type {
+		FBM,	/* Octaves are summed as they are, giving rolling hills */
+		RIDGED	/* Octaves are folded around zero before summing, giving sharp ridges */
+	};
+
+	Type type = FBM;
+	int octaves = 4;			/* Number of octaves, in range [1, NoiseGraph::maxOctaves] */
+	float scale = 256.0f;		/* Size of the first octave in world units, the larger value, the smoother layer */
+	float z = 0.0f;				/* Plane of the noise used by the layer, so layers with the same scale are different */
+	float lacunarity = 2.0f;	/* How many times frequency grows with each octave */
+	float gain = 0.5f;			/* How many times amplitude falls with each octave */
+	float amplitude = 1.0f;		/* Weight of the layer in the sum of all layers */
+	float warp = 0.0f;			/* How far in world units points are moved by the warping noise, 0 disables warping */
+	float warpScale = 128.0f;	/* Size of the warping noise in world units */
+	/*
+	* Curve remapping value of the layer. Values are taken at evenly spaced points of range [-1, 1] and interpolated
+	* linearly between them. Empty curve leaves values as they are.
+	*/
+	std::vector<float> curve;
+};
+
+/*
+* Terrain shape made of noise layers. Value of the point is sum of the layers, each one in range about [-1, 1]
+* before its amplitude is applied. Layers are configured at runtime, but values are always computed for whole rows
+* with the grid kernels of the noise backend. Octaves are combined by functions specialized for the common octave counts,
+* so their loops are fully unrolled and there are no per-sample calls.
+*/
+class NoiseGraph
+{
+public:
+	/* Highest number of octaves of one layer */
+	static const int maxOctaves = 12;
+
+	void AddLayer(const NoiseLayer& layer);
+	void Clear();
+	bool IsEmpty() const;
+	const std::vector<NoiseLayer>& GetLayers() const;
+
+	/*
+	* Fill countX * countZ values of the plane using given noise. Point (i, j) is world position (x0 + i, z0 + j)
+	* and its value is stored at index i + countX * j.
+	*/
+	void Fill(const Noise& noise, float x0, float z0, int countX, int countZ, float* out) const;
+
+private:
+	std::vector<NoiseLayer> _layers;
+
+	/* Add values of the layer in one row to out */
+	static void AddRow(const Noise& noise, const NoiseLayer& layer, float x0, float z, int count, float* planes, float* out);
+	/* Remap value using the curve, curve must not be empty */
+	static float Remap(const std::vector<float>& curve, float value);
+};
+
+inline void
+NoiseGraph::Clear()
+{
+	_layers.clear();
+}
+
+inline bool
+NoiseGraph::IsEmpty() const
+{
+	return _layers.empty();
+}
+
+inline const std::vector<NoiseLayer>&
+NoiseGraph::GetLayers() const
+{
+	return _layers;
+}
+
+}
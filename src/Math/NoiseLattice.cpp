@@ -0,0 +1,118 @@
+#include "NoiseLattice.h"
+#include "NoiseSimd.h"
+
+#include "Assert.h"
+
+#include <vector>
+
+namespace vengine {
+
+static const float stepFraction = 1.0f / NoiseLattice::step;
+
+/* Interpolation used for every axis, the same operations are used by the AVX2 kernel */
+static inline float
+lerp(float t, float a, float b)
+{
+	return a + t * (b - a);
+}
+
+#ifdef VE_NOISE_AVX2
+
+/* Interpolate rows 8 points at a time. Returns number of filled points, rest must be filled by the caller. */
+VE_TARGET_AVX2 static int
+lerpRows8(float t, const float* a, const float* b, int count, float* out)
+{
+	const __m256 tV = _mm256_set1_ps(t);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 aV = _mm256_loadu_ps(a + i);
+		__m256 bV = _mm256_loadu_ps(b + i);
+		_mm256_storeu_ps(out + i, _mm256_add_ps(aV, _mm256_mul_ps(tV, _mm256_sub_ps(bV, aV))));
+	}
+	return i;
+}
+
+#endif
+
+/* Interpolate between two rows of given length */
+static void
+lerpRows(float t, const float* a, const float* b, int count, float* out)
+{
+	int i = 0;
+#ifdef VE_NOISE_AVX2
+	if (Noise::IsVectorized())
+		i = lerpRows8(t, a, b, count, out);
+#endif
+
+	for (; i < count; ++i)
+		out[i] = lerp(t, a[i], b[i]);
+}
+
+void
+NoiseLattice::Fill(const Noise& noise, int x0, int y0, int z0, float scale, int size, float* out)
+{
+	assert(((x0 | y0 | z0 | size) & (step - 1)) == 0, "Box is not aligned to the lattice: (%d, %d, %d) %d.", x0, y0, z0, size);
+
+	const int n = size / step + 1;
+	const float latticeScale = scale / step;
+
+	/* Samples, then rows expanded along x axis, then plane of the rows interpolated along z axis. Buffer is reused by all fills on this thread. */
+	static thread_local std::vector<float> scratch;
+	scratch.resize(n * n * n + n * n * size + n * size);
+	float* lattice = scratch.data();
+	float* expanded = lattice + n * n * n;
+	float* plane = expanded + n * n * size;
+
+	noise.FillGrid3D((float)(x0 / step), (float)(y0 / step), (float)(z0 / step), latticeScale, n, n, n, lattice);
+
+	/* Rows of the lattice are short, so they are expanded point by point */
+	for (int row = 0; row < n * n; ++row) {
+		const float* samples = lattice + n * row;
+		float* values = expanded + size * row;
+		for (int i = 0; i < size; ++i)
+			values[i] = lerp((i % step) * stepFraction, samples[i / step], samples[i / step + 1]);
+	}
+
+	/* Everything else is interpolation of whole rows */
+	for (int k = 0; k < size; ++k) {
+		const float* below = expanded + size * n * (k / step);
+		lerpRows((k % step) * stepFraction, below, below + size * n, size * n, plane);
+
+		for (int j = 0; j < size; ++j) {
+			const float* row = plane + size * (j / step);
+			lerpRows((j % step) * stepFraction, row, row + size, size, out + size * (j + size * k));
+		}
+	}
+}
+
+float
+NoiseLattice::GetValue(const Noise& noise, int x, int y, int z, float scale)
+{
+	const float latticeScale = scale / step;
+
+	/* Lattice cell containing the point, coordinates can be negative */
+	int cellX = (x & ~(step - 1)) / step;
+	int cellY = (y & ~(step - 1)) / step;
+	int cellZ = (z & ~(step - 1)) / step;
+
+	/* Interpolated in the same order as in Fill: along x, then z, then y */
+	float rows[2][2];
+	for (int dz = 0; dz < 2; ++dz) {
+		for (int dy = 0; dy < 2; ++dy) {
+			float sampleY = (float)(cellY + dy) / latticeScale;
+			float sampleZ = (float)(cellZ + dz) / latticeScale;
+			float a = noise.GetNoise((float)cellX / latticeScale, sampleY, sampleZ);
+			float b = noise.GetNoise((float)(cellX + 1) / latticeScale, sampleY, sampleZ);
+			rows[dz][dy] = lerp((x & (step - 1)) * stepFraction, a, b);
+		}
+	}
+
+	float tz = (z & (step - 1)) * stepFraction;
+	float low = lerp(tz, rows[0][0], rows[1][0]);
+	float high = lerp(tz, rows[0][1], rows[1][1]);
+
+	return lerp((y & (step - 1)) * stepFraction, low, high);
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Noise.h"
+
+namespace vengine {
+
+/*
+* 3D noise sampled on a coarse lattice and trilinearly interpolated to every point of a box. Box of size^3 points
+* needs only (size / step + 1)^3 samples of noise instead of size^3, so density of every voxel is affordable.
+* Lattice is aligned to the multiples of the step, so neighbouring boxes share their border samples and values
+* are continuous between them. Rows are interpolated 8 points at a time on processors with AVX2, giving exactly
+* the same values as GetValue.
+*/
+class NoiseLattice
+{
+public:
+	/* Distance between the samples of the lattice in points */
+	static const int step = 4;
+
+	/*
+	* Fill size^3 values of the box starting at point (x0, y0, z0). Point (i, j, k) is noise of the space at
+	* ((x0 + i) / scale, (y0 + j) / scale, (z0 + k) / scale) interpolated from the lattice and its value is stored
+	* at index i + size * (j + size * k). Corner of the box and its size must be multiples of the step.
+	*/
+	static void Fill(const Noise& noise, int x0, int y0, int z0, float scale, int size, float* out);
+	/* Get interpolated value of one point, the same as the one filled in any box containing the point */
+	static float GetValue(const Noise& noise, int x, int y, int z, float scale);
+};
+
+}
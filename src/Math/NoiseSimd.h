@@ -0,0 +1,25 @@
+#pragma once
+
+/*
+* Settings shared by the sources of the noise backends, it must not be included by other files.
+* AVX2 kernels are compiled for x86 processors and chosen at runtime, so the engine still runs without AVX2.
+*/
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define VE_NOISE_AVX2
+#define VE_TARGET_AVX2
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define VE_NOISE_AVX2
+#define VE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+/* Noise must be the same on every processor, so compiler must not fuse multiplications and additions on its own */
+#if defined(_MSC_VER)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
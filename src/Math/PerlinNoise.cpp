@@ -1,4 +1,7 @@
 #include "PerlinNoise.h"
+#include "NoiseSimd.h"
+
+#include <cmath>
 
 namespace vengine {
 
@@ -17,13 +20,7 @@ PerlinNoise::PerlinNoise(unsigned int seed)
 void
 PerlinNoise::SetSeed(unsigned int seed) 
 {
-	_permutation.resize(256);
-	std::iota(_permutation.begin(), _permutation.end(), 0);
-
-	std::default_random_engine engine(seed);
-	std::shuffle(_permutation.begin(), _permutation.end(), engine);
-
-	_permutation.insert(_permutation.end(), _permutation.begin(), _permutation.end());
+	BuildPermutation(seed, _permutation);
 }
 
 float 
@@ -35,7 +32,8 @@ PerlinNoise::Fade(float t)
 float
 PerlinNoise::Lerp(float t, float a, float b)
 {
-	return fma(t, b - a, a);
+	/* Single precision fused operation, the same as the one used by the AVX2 kernel */
+	return std::fma(t, b - a, a);
 }
 
 float 
@@ -49,7 +47,13 @@ PerlinNoise::Grad(int hash, float x, float y, float z)
 }
 
 float
-PerlinNoise::GetNoise(float x, float y, float z) {
+PerlinNoise::GetPlaneNoise(float x, float y, float z) const
+{
+	return GetNoise(x, y, z);
+}
+
+float
+PerlinNoise::GetNoise(float x, float y, float z) const {
 	// Find the unit cube that contains the point
 	int X = (int)floor(x) & 255;
 	int Y = (int)floor(y) & 255;
@@ -79,4 +83,163 @@ PerlinNoise::GetNoise(float x, float y, float z) {
 	return Lerp(w, Lerp(v, p1, p2), Lerp(v, p3, p4));
 }
 
-}
\ No newline at end of file
+#ifdef VE_NOISE_AVX2
+
+/* The same operations as in Fade, in the same order */
+VE_TARGET_AVX2 static inline __m256
+fade8(__m256 t)
+{
+	__m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))), _mm256_set1_ps(10.0f));
+	return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+}
+
+VE_TARGET_AVX2 static inline __m256
+lerp8(__m256 t, __m256 a, __m256 b)
+{
+	return _mm256_fmadd_ps(t, _mm256_sub_ps(b, a), a);
+}
+
+/* Branchless Grad - gradient components are chosen with blends and signs are flipped with xor */
+VE_TARGET_AVX2 static inline __m256
+grad8(__m256i hash, __m256 x, __m256 y, __m256 z)
+{
+	__m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+
+	__m256 lessThan8 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h));
+	__m256 lessThan4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h));
+	__m256 twelveOrFourteen = _mm256_castsi256_ps(_mm256_or_si256(_mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)),
+																   _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14))));
+
+	__m256 u = _mm256_blendv_ps(y, x, lessThan8);
+	__m256 v = _mm256_blendv_ps(_mm256_blendv_ps(z, x, twelveOrFourteen), y, lessThan4);
+
+	__m256 signU = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31));
+	__m256 signV = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+
+	return _mm256_add_ps(_mm256_xor_ps(u, signU), _mm256_xor_ps(v, signV));
+}
+
+/* Noise of 8 points, permutation table is read with gathers */
+VE_TARGET_AVX2 static inline __m256
+noise8(const int* permutation, __m256 x, __m256 y, __m256 z)
+{
+	const __m256i mask = _mm256_set1_epi32(255);
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256 oneF = _mm256_set1_ps(1.0f);
+
+	__m256 floorX = _mm256_floor_ps(x);
+	__m256 floorY = _mm256_floor_ps(y);
+	__m256 floorZ = _mm256_floor_ps(z);
+
+	__m256i X = _mm256_and_si256(_mm256_cvttps_epi32(floorX), mask);
+	__m256i Y = _mm256_and_si256(_mm256_cvttps_epi32(floorY), mask);
+	__m256i Z = _mm256_and_si256(_mm256_cvttps_epi32(floorZ), mask);
+
+	x = _mm256_sub_ps(x, floorX);
+	y = _mm256_sub_ps(y, floorY);
+	z = _mm256_sub_ps(z, floorZ);
+
+	__m256 u = fade8(x);
+	__m256 v = fade8(y);
+	__m256 w = fade8(z);
+
+	__m256i A = _mm256_add_epi32(_mm256_i32gather_epi32(permutation, X, 4), Y);
+	__m256i AA = _mm256_add_epi32(_mm256_i32gather_epi32(permutation, A, 4), Z);
+	__m256i AB = _mm256_add_epi32(_mm256_i32gather_epi32(permutation, _mm256_add_epi32(A, one), 4), Z);
+	__m256i B = _mm256_add_epi32(_mm256_i32gather_epi32(permutation, _mm256_add_epi32(X, one), 4), Y);
+	__m256i BA = _mm256_add_epi32(_mm256_i32gather_epi32(permutation, B, 4), Z);
+	__m256i BB = _mm256_add_epi32(_mm256_i32gather_epi32(permutation, _mm256_add_epi32(B, one), 4), Z);
+
+	__m256 x1 = _mm256_sub_ps(x, oneF);
+	__m256 y1 = _mm256_sub_ps(y, oneF);
+	__m256 z1 = _mm256_sub_ps(z, oneF);
+
+	__m256 p1 = lerp8(u, grad8(_mm256_i32gather_epi32(permutation, AA, 4), x, y, z),
+						 grad8(_mm256_i32gather_epi32(permutation, BA, 4), x1, y, z));
+	__m256 p2 = lerp8(u, grad8(_mm256_i32gather_epi32(permutation, AB, 4), x, y1, z),
+						 grad8(_mm256_i32gather_epi32(permutation, BB, 4), x1, y1, z));
+	__m256 p3 = lerp8(u, grad8(_mm256_i32gather_epi32(permutation, _mm256_add_epi32(AA, one), 4), x, y, z1),
+						 grad8(_mm256_i32gather_epi32(permutation, _mm256_add_epi32(BA, one), 4), x1, y, z1));
+	__m256 p4 = lerp8(u, grad8(_mm256_i32gather_epi32(permutation, _mm256_add_epi32(AB, one), 4), x, y1, z1),
+						 grad8(_mm256_i32gather_epi32(permutation, _mm256_add_epi32(BB, one), 4), x1, y1, z1));
+
+	return lerp8(w, lerp8(v, p1, p2), lerp8(v, p3, p4));
+}
+
+/* Fill row of points, 8 at a time. Returns number of filled points, rest must be filled by the caller. */
+VE_TARGET_AVX2 static int
+fillRow8(const int* permutation, float x0, float y, float z, float scale, int count, float* out)
+{
+	const __m256 steps = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+	const __m256 scaleV = _mm256_set1_ps(scale);
+	const __m256 yV = _mm256_set1_ps(y);
+	const __m256 zV = _mm256_set1_ps(z);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		/* (x0 + i) / scale, rounded the same way as in the scalar code */
+		__m256 index = _mm256_add_ps(_mm256_set1_ps((float)i), steps);
+		__m256 x = _mm256_div_ps(_mm256_add_ps(_mm256_set1_ps(x0), index), scaleV);
+		_mm256_storeu_ps(out + i, noise8(permutation, x, yV, zV));
+	}
+	return i;
+}
+
+/* Fill arbitrary points, 8 at a time. Returns number of filled points, rest must be filled by the caller. */
+VE_TARGET_AVX2 static int
+fillPoints8(const int* permutation, const float* x, const float* y, float z, int count, float* out)
+{
+	const __m256 zV = _mm256_set1_ps(z);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(out + i, noise8(permutation, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), zV));
+	return i;
+}
+
+#endif
+
+void
+PerlinNoise::FillRow(float x0, float y, float z, float scale, int count, float* out) const
+{
+	int i = 0;
+#ifdef VE_NOISE_AVX2
+	if (IsVectorized())
+		i = fillRow8(_permutation, x0, y, z, scale, count, out);
+#endif
+
+	for (; i < count; ++i)
+		out[i] = GetNoise((x0 + i) / scale, y, z);
+}
+
+void
+PerlinNoise::FillGrid2D(float x0, float y0, float z, float scale, int countX, int countY, float* out) const
+{
+	for (int j = 0; j < countY; ++j)
+		FillRow(x0, (y0 + j) / scale, z, scale, countX, out + countX * j);
+}
+
+void
+PerlinNoise::FillGrid3D(float x0, float y0, float z0, float scale, int countX, int countY, int countZ, float* out) const
+{
+	for (int k = 0; k < countZ; ++k) {
+		float z = (z0 + k) / scale;
+		for (int j = 0; j < countY; ++j)
+			FillRow(x0, (y0 + j) / scale, z, scale, countX, out + countX * (j + countY * k));
+	}
+}
+
+void
+PerlinNoise::FillPoints(const float* x, const float* y, float z, int count, float* out) const
+{
+	int i = 0;
+#ifdef VE_NOISE_AVX2
+	if (IsVectorized())
+		i = fillPoints8(_permutation, x, y, z, count, out);
+#endif
+
+	for (; i < count; ++i)
+		out[i] = GetNoise(x[i], y[i], z);
+}
+
+}
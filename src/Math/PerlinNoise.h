@@ -1,30 +1,43 @@
 #pragma once
 
+#include "Noise.h"
+
 #include <vector>
-#include <random>
-#include <numeric>
 #include <algorithm>
 
 namespace vengine {
-/* Generator of the perlins noise. Source: http://mrl.nyu.edu/~perlin/noise/ */
-class PerlinNoise
+/*
+* Generator of the perlins noise. Source: http://mrl.nyu.edu/~perlin/noise/
+* Grids of values can be filled at once. On processors with AVX2 and FMA they are computed 8 points at a time,
+* giving exactly the same values as GetNoise, so the terrain does not depend on the processor.
+* Planes are slices of the 3D noise at constant z, so every sample blends 8 corners of the cube.
+*/
+class PerlinNoise : public Noise
 {
 public:
 	PerlinNoise();
 	PerlinNoise(unsigned int seed);
 
-	void SetSeed(unsigned int seed);
+	virtual void SetSeed(unsigned int seed);
+
+	virtual float GetNoise(float x, float y, float z) const;
+	/* The same as GetNoise, plane is the slice at constant z */
+	virtual float GetPlaneNoise(float x, float y, float z) const;
 
-	float GetNoise(float x, float y, float z);
+	virtual void FillGrid2D(float x0, float y0, float z, float scale, int countX, int countY, float* out) const;
+	virtual void FillGrid3D(float x0, float y0, float z0, float scale, int countX, int countY, int countZ, float* out) const;
+	virtual void FillPoints(const float* x, const float* y, float z, int count, float* out) const;
 
 private:
 	unsigned int _seed = 518331203u;
-	std::vector<int> _permutation;
+	int _permutation[512];	/* Shuffled numbers 0-255 repeated twice, so corners of the cube can be hashed without wrapping */
 
+	/* Fill values of given number of points lying in a row along x axis, starting at ((x0 + i) / scale, y, z) */
+	void FillRow(float x0, float y, float z, float scale, int count, float* out) const;
 
-	float Fade(float t);
-	float Lerp(float t, float a, float b);
-	float Grad(int hash, float x, float y, float z);
+	static float Fade(float t);
+	static float Lerp(float t, float a, float b);
+	static float Grad(int hash, float x, float y, float z);
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,322 @@
+#include "SimplexNoise.h"
+#include "NoiseSimd.h"
+
+#include <cmath>
+
+namespace vengine {
+
+/* Skewing factors between the grid of squares and the grid of triangles: (sqrt(3) - 1) / 2 and (3 - sqrt(3)) / 6 */
+static const float skew2 = 0.366025403f;
+static const float unskew2 = 0.211324865f;
+static const float unskew2Twice = 2.0f * unskew2;
+static const float skew3 = 1.0f / 3.0f;
+static const float unskew3 = 1.0f / 6.0f;
+
+/* Noise is scaled to range about [-1, 1] */
+static const float scale2 = 40.0f;
+static const float scale3 = 32.0f;
+
+/* How far the plane is moved for each unit of z, not integer, so planes do not fall on the same grid */
+static const float planeShiftX = 131.7f;
+static const float planeShiftY = 97.3f;
+
+SimplexNoise::SimplexNoise()
+{
+	SetSeed(518331203u);
+}
+
+SimplexNoise::SimplexNoise(unsigned int seed)
+{
+	SetSeed(seed);
+}
+
+void
+SimplexNoise::SetSeed(unsigned int seed)
+{
+	/* The same permutation as the one of PerlinNoise with this seed */
+	BuildPermutation(seed, _permutation);
+}
+
+float
+SimplexNoise::Grad2(int hash, float x, float y)
+{
+	int h = hash & 7;
+	float u = h < 4 ? x : y;
+	float v = h < 4 ? y : x;
+
+	return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? 2.0f * v : -2.0f * v);
+}
+
+float
+SimplexNoise::Grad3(int hash, float x, float y, float z)
+{
+	int h = hash & 15;
+	float u = h < 8 ? x : y;
+	float v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+
+	return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+}
+
+/* Contribution of one corner of the triangle, falloff is clamped with the same comparison as in the AVX2 kernel */
+static inline float
+corner2(float x, float y, float gradient)
+{
+	float t = 0.5f - x * x - y * y;
+	t = t > 0.0f ? t : 0.0f;
+	t = t * t;
+	return t * t * gradient;
+}
+
+float
+SimplexNoise::GetNoise2D(float x, float y) const
+{
+	/* Find the triangle containing the point, first in skewed space, then the offset from its first corner */
+	float s = (x + y) * skew2;
+	float fi = std::floor(x + s);
+	float fj = std::floor(y + s);
+	float t = (fi + fj) * unskew2;
+	float x0 = x - (fi - t);
+	float y0 = y - (fj - t);
+
+	/* Point is in the lower or upper triangle of the square */
+	int i1 = x0 > y0 ? 1 : 0;
+	int j1 = 1 - i1;
+
+	float x1 = x0 - (float)i1 + unskew2;
+	float y1 = y0 - (float)j1 + unskew2;
+	float x2 = x0 - 1.0f + unskew2Twice;
+	float y2 = y0 - 1.0f + unskew2Twice;
+
+	int ii = (int)fi & 255;
+	int jj = (int)fj & 255;
+
+	float n0 = corner2(x0, y0, Grad2(_permutation[ii + _permutation[jj]], x0, y0));
+	float n1 = corner2(x1, y1, Grad2(_permutation[ii + i1 + _permutation[jj + j1]], x1, y1));
+	float n2 = corner2(x2, y2, Grad2(_permutation[ii + 1 + _permutation[jj + 1]], x2, y2));
+
+	return scale2 * (n0 + n1 + n2);
+}
+
+float
+SimplexNoise::GetPlaneNoise(float x, float y, float z) const
+{
+	return GetNoise2D(x + z * planeShiftX, y + z * planeShiftY);
+}
+
+float
+SimplexNoise::GetNoise(float x, float y, float z) const
+{
+	/* Find the tetrahedron containing the point */
+	float s = (x + y + z) * skew3;
+	float fi = std::floor(x + s);
+	float fj = std::floor(y + s);
+	float fk = std::floor(z + s);
+	float t = (fi + fj + fk) * unskew3;
+	float x0 = x - (fi - t);
+	float y0 = y - (fj - t);
+	float z0 = z - (fk - t);
+
+	/* Second and third corner depend on the order of the offsets */
+	int i1, j1, k1, i2, j2, k2;
+	if (x0 >= y0) {
+		if (y0 >= z0) { i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 1; k2 = 0; }
+		else if (x0 >= z0) { i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 0; k2 = 1; }
+		else { i1 = 0; j1 = 0; k1 = 1; i2 = 1; j2 = 0; k2 = 1; }
+	}
+	else {
+		if (y0 < z0) { i1 = 0; j1 = 0; k1 = 1; i2 = 0; j2 = 1; k2 = 1; }
+		else if (x0 < z0) { i1 = 0; j1 = 1; k1 = 0; i2 = 0; j2 = 1; k2 = 1; }
+		else { i1 = 0; j1 = 1; k1 = 0; i2 = 1; j2 = 1; k2 = 0; }
+	}
+
+	float offsets[4][3] = {
+		{ x0, y0, z0 },
+		{ x0 - i1 + unskew3, y0 - j1 + unskew3, z0 - k1 + unskew3 },
+		{ x0 - i2 + 2.0f * unskew3, y0 - j2 + 2.0f * unskew3, z0 - k2 + 2.0f * unskew3 },
+		{ x0 - 1.0f + 3.0f * unskew3, y0 - 1.0f + 3.0f * unskew3, z0 - 1.0f + 3.0f * unskew3 }
+	};
+
+	int ii = (int)fi & 255;
+	int jj = (int)fj & 255;
+	int kk = (int)fk & 255;
+	int hashes[4] = {
+		_permutation[ii + _permutation[jj + _permutation[kk]]],
+		_permutation[ii + i1 + _permutation[jj + j1 + _permutation[kk + k1]]],
+		_permutation[ii + i2 + _permutation[jj + j2 + _permutation[kk + k2]]],
+		_permutation[ii + 1 + _permutation[jj + 1 + _permutation[kk + 1]]]
+	};
+
+	float sum = 0.0f;
+	for (int c = 0; c < 4; ++c) {
+		const float* p = offsets[c];
+		float falloff = 0.6f - p[0] * p[0] - p[1] * p[1] - p[2] * p[2];
+		if (falloff > 0.0f) {
+			falloff *= falloff;
+			sum += falloff * falloff * Grad3(hashes[c], p[0], p[1], p[2]);
+		}
+	}
+
+	return scale3 * sum;
+}
+
+#ifdef VE_NOISE_AVX2
+
+/* Branchless Grad2 - gradient components are swapped with blends and signs are flipped with xor */
+VE_TARGET_AVX2 static inline __m256
+grad2x8(__m256i hash, __m256 x, __m256 y)
+{
+	__m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(7));
+	__m256 lessThan4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h));
+
+	__m256 u = _mm256_blendv_ps(y, x, lessThan4);
+	__m256 v = _mm256_mul_ps(_mm256_set1_ps(2.0f), _mm256_blendv_ps(x, y, lessThan4));
+
+	__m256 signU = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31));
+	__m256 signV = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+
+	return _mm256_add_ps(_mm256_xor_ps(u, signU), _mm256_xor_ps(v, signV));
+}
+
+/* The same operations as in corner2, in the same order */
+VE_TARGET_AVX2 static inline __m256
+corner2x8(__m256 x, __m256 y, __m256 gradient)
+{
+	__m256 t = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(0.5f), _mm256_mul_ps(x, x)), _mm256_mul_ps(y, y));
+	t = _mm256_max_ps(t, _mm256_setzero_ps());
+	t = _mm256_mul_ps(t, t);
+	return _mm256_mul_ps(_mm256_mul_ps(t, t), gradient);
+}
+
+/* 2D noise of 8 points, permutation table is read with gathers */
+VE_TARGET_AVX2 static inline __m256
+noise2x8(const int* permutation, __m256 x, __m256 y)
+{
+	const __m256i mask = _mm256_set1_epi32(255);
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256 oneF = _mm256_set1_ps(1.0f);
+	const __m256 unskew = _mm256_set1_ps(unskew2);
+	const __m256 unskewTwice = _mm256_set1_ps(unskew2Twice);
+
+	__m256 s = _mm256_mul_ps(_mm256_add_ps(x, y), _mm256_set1_ps(skew2));
+	__m256 fi = _mm256_floor_ps(_mm256_add_ps(x, s));
+	__m256 fj = _mm256_floor_ps(_mm256_add_ps(y, s));
+	__m256 t = _mm256_mul_ps(_mm256_add_ps(fi, fj), unskew);
+	__m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(fi, t));
+	__m256 y0 = _mm256_sub_ps(y, _mm256_sub_ps(fj, t));
+
+	__m256 lower = _mm256_cmp_ps(x0, y0, _CMP_GT_OQ);
+	__m256i i1 = _mm256_and_si256(_mm256_castps_si256(lower), one);
+	__m256i j1 = _mm256_sub_epi32(one, i1);
+
+	__m256 x1 = _mm256_add_ps(_mm256_sub_ps(x0, _mm256_cvtepi32_ps(i1)), unskew);
+	__m256 y1 = _mm256_add_ps(_mm256_sub_ps(y0, _mm256_cvtepi32_ps(j1)), unskew);
+	__m256 x2 = _mm256_add_ps(_mm256_sub_ps(x0, oneF), unskewTwice);
+	__m256 y2 = _mm256_add_ps(_mm256_sub_ps(y0, oneF), unskewTwice);
+
+	__m256i ii = _mm256_and_si256(_mm256_cvttps_epi32(fi), mask);
+	__m256i jj = _mm256_and_si256(_mm256_cvttps_epi32(fj), mask);
+
+	__m256i h0 = _mm256_i32gather_epi32(permutation, _mm256_add_epi32(ii, _mm256_i32gather_epi32(permutation, jj, 4)), 4);
+	__m256i h1 = _mm256_i32gather_epi32(permutation, _mm256_add_epi32(_mm256_add_epi32(ii, i1),
+										_mm256_i32gather_epi32(permutation, _mm256_add_epi32(jj, j1), 4)), 4);
+	__m256i h2 = _mm256_i32gather_epi32(permutation, _mm256_add_epi32(_mm256_add_epi32(ii, one),
+										_mm256_i32gather_epi32(permutation, _mm256_add_epi32(jj, one), 4)), 4);
+
+	__m256 n0 = corner2x8(x0, y0, grad2x8(h0, x0, y0));
+	__m256 n1 = corner2x8(x1, y1, grad2x8(h1, x1, y1));
+	__m256 n2 = corner2x8(x2, y2, grad2x8(h2, x2, y2));
+
+	return _mm256_mul_ps(_mm256_set1_ps(scale2), _mm256_add_ps(_mm256_add_ps(n0, n1), n2));
+}
+
+/* Fill row of the moved plane, 8 points at a time. Returns number of filled points, rest must be filled by the caller. */
+VE_TARGET_AVX2 static int
+fillRow2x8(const int* permutation, float x0, float y, float shiftX, float scale, int count, float* out)
+{
+	const __m256 steps = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+	const __m256 scaleV = _mm256_set1_ps(scale);
+	const __m256 shiftV = _mm256_set1_ps(shiftX);
+	const __m256 yV = _mm256_set1_ps(y);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		/* (x0 + i) / scale moved by the plane, rounded the same way as in the scalar code */
+		__m256 index = _mm256_add_ps(_mm256_set1_ps((float)i), steps);
+		__m256 x = _mm256_add_ps(_mm256_div_ps(_mm256_add_ps(_mm256_set1_ps(x0), index), scaleV), shiftV);
+		_mm256_storeu_ps(out + i, noise2x8(permutation, x, yV));
+	}
+	return i;
+}
+
+/* Fill arbitrary points of the moved plane, 8 at a time. Returns number of filled points. */
+VE_TARGET_AVX2 static int
+fillPoints2x8(const int* permutation, const float* x, const float* y, float shiftX, float shiftY, int count, float* out)
+{
+	const __m256 shiftXV = _mm256_set1_ps(shiftX);
+	const __m256 shiftYV = _mm256_set1_ps(shiftY);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 pointX = _mm256_add_ps(_mm256_loadu_ps(x + i), shiftXV);
+		__m256 pointY = _mm256_add_ps(_mm256_loadu_ps(y + i), shiftYV);
+		_mm256_storeu_ps(out + i, noise2x8(permutation, pointX, pointY));
+	}
+	return i;
+}
+
+#endif
+
+void
+SimplexNoise::FillRow(float x0, float y, float z, float scale, int count, float* out) const
+{
+	float shiftX = z * planeShiftX;
+	float shiftY = z * planeShiftY;
+
+	int i = 0;
+#ifdef VE_NOISE_AVX2
+	if (IsVectorized())
+		i = fillRow2x8(_permutation, x0, y + shiftY, shiftX, scale, count, out);
+#endif
+
+	for (; i < count; ++i)
+		out[i] = GetNoise2D((x0 + i) / scale + shiftX, y + shiftY);
+}
+
+void
+SimplexNoise::FillGrid2D(float x0, float y0, float z, float scale, int countX, int countY, float* out) const
+{
+	for (int j = 0; j < countY; ++j)
+		FillRow(x0, (y0 + j) / scale, z, scale, countX, out + countX * j);
+}
+
+void
+SimplexNoise::FillGrid3D(float x0, float y0, float z0, float scale, int countX, int countY, int countZ, float* out) const
+{
+	for (int k = 0; k < countZ; ++k) {
+		float z = (z0 + k) / scale;
+		for (int j = 0; j < countY; ++j) {
+			float y = (y0 + j) / scale;
+			float* row = out + countX * (j + countY * k);
+			for (int i = 0; i < countX; ++i)
+				row[i] = GetNoise((x0 + i) / scale, y, z);
+		}
+	}
+}
+
+void
+SimplexNoise::FillPoints(const float* x, const float* y, float z, int count, float* out) const
+{
+	float shiftX = z * planeShiftX;
+	float shiftY = z * planeShiftY;
+
+	int i = 0;
+#ifdef VE_NOISE_AVX2
+	if (IsVectorized())
+		i = fillPoints2x8(_permutation, x, y, shiftX, shiftY, count, out);
+#endif
+
+	for (; i < count; ++i)
+		out[i] = GetNoise2D(x[i] + shiftX, y[i] + shiftY);
+}
+
+}
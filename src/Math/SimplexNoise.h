@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Noise.h"
+
+namespace vengine {
+
+/*
+* Simplex noise. Source: Stefan Gustavson, "Simplex noise demystified"
+* Space is split into triangles in 2D and tetrahedrons in 3D instead of squares and cubes, so a sample needs only
+* 3 corners in 2D and 4 corners in 3D and there is no interpolation between them. Planes are sampled with true 2D noise,
+* plane identified by z is the 2D noise moved by a distance proportional to z, so planes are not correlated.
+* Rows of the planes are computed 8 points at a time on processors with AVX2, giving exactly the same values as
+* GetPlaneNoise. 3D noise is computed point by point.
+*/
+class SimplexNoise : public Noise
+{
+public:
+	SimplexNoise();
+	SimplexNoise(unsigned int seed);
+
+	virtual void SetSeed(unsigned int seed);
+
+	virtual float GetNoise(float x, float y, float z) const;
+	virtual float GetPlaneNoise(float x, float y, float z) const;
+
+	virtual void FillGrid2D(float x0, float y0, float z, float scale, int countX, int countY, float* out) const;
+	virtual void FillGrid3D(float x0, float y0, float z0, float scale, int countX, int countY, int countZ, float* out) const;
+	virtual void FillPoints(const float* x, const float* y, float z, int count, float* out) const;
+
+private:
+	int _permutation[512];	/* Shuffled numbers 0-255 repeated twice, so corners can be hashed without wrapping */
+
+	/* Get 2D noise at given point */
+	float GetNoise2D(float x, float y) const;
+	/* Fill values of given number of points lying in a row along x axis, starting at ((x0 + i) / scale, y) of the plane */
+	void FillRow(float x0, float y, float z, float scale, int count, float* out) const;
+
+	static float Grad2(int hash, float x, float y);
+	static float Grad3(int hash, float x, float y, float z);
+};
+
+}
@@ -56,6 +56,8 @@ GlBuffer::ReserveMutableSizeData(const void* data, GLsizeiptr size, DataFlags us
 	assert(IsValid(), "Cannot set data of unitialized buffer.");
 
 	_bufferSize = size;
+	/* Mutable storage can always be modified with ChangeData */
+	_flags = DYNAMIC;
 	glNamedBufferData(_handle, size, data, usage);
 }
 
@@ -66,6 +68,7 @@ GlBuffer::ReserveFixedSizeData(const void* data, GLsizeiptr size, GLbitfield fla
 	assert(IsValid(), "Cannot set data of unitialized buffer.");
 	
 	_bufferSize = size;
+	_flags = flags;
 	glNamedBufferStorage(_handle, size, data, flags);
 }
 
@@ -73,7 +76,7 @@ void
 GlBuffer::ChangeData(GLintptr start, const void* data, GLsizeiptr size)
 {
 	assert(IsValid(), "Cannot change buffer data, must be initalized first");
-	assert(start + size < _bufferSize, "Size of the written data would exceed buffer size");
+	assert(start + size <= _bufferSize, "Size of the written data would exceed buffer size");
 	assert((_flags & DYNAMIC) != 0, "Buffer is not dynamic. Cannot modify data");
 
 	glNamedBufferSubData(_handle, start, size, data);
@@ -49,6 +49,14 @@ VertexArray::ActivateBinded(GLuint attribute, GLuint numParams, GLenum type, GLs
 		start);
 }
 
+void
+VertexArray::ActivateBindedInteger(GLuint attribute, GLuint numParams, GLenum type, GLsizei size, GLvoid* start)
+{
+	assert(IsBinded(), "Activating parameter for unbinded VAO!");
+	glEnableVertexAttribArray(attribute);
+	glVertexAttribIPointer(attribute, numParams, type, size, start);
+}
+
 GLuint 
 VertexArray::GetGLHandle() const
 {
@@ -25,6 +25,8 @@ public:
 	void Bind();
 	void Unbind();
 	void ActivateBinded(GLuint attribute, GLuint numParams, GLenum type, GLsizei size, GLvoid* start);
+	/* Activate attribute, which is passed to the shader as integer without converting to float */
+	void ActivateBindedInteger(GLuint attribute, GLuint numParams, GLenum type, GLsizei size, GLvoid* start);
 
 	GLuint GetGLHandle() const;
 	bool IsValid() const;
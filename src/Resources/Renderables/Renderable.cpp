@@ -33,6 +33,21 @@ Renderable::AddVertices(const Vertices& vertices, const Indices& indices)
 	_changed = true;
 }
 
+void
+Renderable::AddVertices(const Vertex* vertices, size_t verticesNumber, const GLuint* indices, size_t indicesNumber)
+{
+	_vertices.insert(std::end(_vertices), vertices, vertices + verticesNumber);
+	_indices.insert(std::end(_indices), indices, indices + indicesNumber);
+	_changed = true;
+}
+
+void
+Renderable::Reserve(size_t verticesNumber, size_t indicesNumber)
+{
+	_vertices.reserve(verticesNumber);
+	_indices.reserve(indicesNumber);
+}
+
 void
 Renderable::ClearVertices()
 {
@@ -48,19 +63,37 @@ Renderable::UpdateBuffers()
 	_vao.Bind();
 
 	_vbo.Bind(GlBuffer::VERTEX);
-	_vbo.ReserveMutableSizeData(_vertices.data(), _vertices.size() * sizeof(Vertex), GlBuffer::DYNAMIC_DRAW);
+	UpdateVertexBuffer();
 	ActivateAttributes();
 	_vbo.Unbind(GlBuffer::VERTEX);
 
-	_ebo.Bind(GlBuffer::INDICES);
-	_ebo.ReserveMutableSizeData(_indices.data(), _indices.size() * sizeof(GLuint), GlBuffer::DYNAMIC_DRAW);
-	_ebo.Unbind(GlBuffer::INDICES);
+	UpdateIndexBuffer();
 
 	_vao.Unbind();
 
 	_changed = false;
 }
 
+void
+Renderable::UpdateVertexBuffer()
+{
+	_vbo.ReserveMutableSizeData(_vertices.data(), _vertices.size() * sizeof(Vertex), GlBuffer::DYNAMIC_DRAW);
+}
+
+void
+Renderable::UpdateIndexBuffer()
+{
+	_ebo.Bind(GlBuffer::INDICES);
+	_ebo.ReserveMutableSizeData(_indices.data(), _indices.size() * sizeof(GLuint), GlBuffer::DYNAMIC_DRAW);
+	_ebo.Unbind(GlBuffer::INDICES);
+}
+
+void
+Renderable::BindIndexBuffer()
+{
+	_ebo.Bind(GlBuffer::INDICES);
+}
+
 void 
 Renderable::DrawStart(RenderInfo* info)
 {
@@ -71,7 +104,7 @@ Renderable::DrawStart(RenderInfo* info)
 	FillInfo(info);
 
 	_vao.Bind();
-	_ebo.Bind(GlBuffer::INDICES);
+	BindIndexBuffer();
 }
 
 void 
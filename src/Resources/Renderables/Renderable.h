@@ -23,7 +23,7 @@ public:
 	/* Initializes all obejcts used for rendering */
 	void Init();
 	/* Deleteas all resources */
-	void Delete();
+	virtual void Delete();
 
 	/* Get vertices stored in renderable object */
 	const Vertices& GetVertices();
@@ -32,8 +32,12 @@ public:
 
 	/* Add new vertices to the renderable. It will be markes as changed. */
 	void AddVertices(const Vertices& vertices, const Indices& indices);
+	/* Add new vertices from plain arrays, so they can be prepared on the stack without allocating vectors. */
+	void AddVertices(const Vertex* vertices, size_t verticesNumber, const GLuint* indices, size_t indicesNumber);
+	/* Reserve space for vertices and indices. Cleared renderable is keeping its memory, so it is needed only when it grows. */
+	void Reserve(size_t verticesNumber, size_t indicesNumber);
 	/* Delete all vertices from the renderable. */
-	void ClearVertices();
+	virtual void ClearVertices();
 
 	/* Drawing routine - it should call DrawStart first, then render everything and DrawEnd at the end */
 	virtual void Draw(Renderer* renderer) = 0;
@@ -58,6 +62,12 @@ protected:
 	Indices _indices;	/* Indices of the renderable */
 
 	void UpdateBuffers();	/* Updates buffers and set that object is not changed */
+	/* Send vertices to the binded VBO. Can be overloaded by objects storing vertices in different format. */
+	virtual void UpdateVertexBuffer();
+	/* Send indices to the EBO. Can be overloaded by objects, which are not storing their own indices. */
+	virtual void UpdateIndexBuffer();
+	/* Bind EBO used for drawing */
+	virtual void BindIndexBuffer();
 
 	/* If object changed, update buffers. Call FillInfo and fill RenderInfo structure. Bind VAO and EBO. */
 	void DrawStart(RenderInfo* info); 
@@ -1,14 +1,184 @@
 #include "VoxelMesh.h"
 
+#include <algorithm>
+
 namespace vengine {
 
 unsigned int VoxelMesh::_atlas = 0;
+GlBuffer VoxelMesh::_quadIndices;
+size_t VoxelMesh::_quadIndicesCapacity = 0;
+
+VoxelMesh::VoxelMesh() : _dirtyBegin(0), _dirtyEnd(0), _uploadAll(true), _voxelSize(1.0f), _voxelCenter(Vector3::zeroes)
+{
+}
+
+void
+VoxelMesh::Delete()
+{
+	Mesh::Delete();
+	_voxelVertices.clear();
+	_sliceEnds.clear();
+	_uploadAll = true;
+}
+
+void
+VoxelMesh::AddQuads(const VoxelVertex* vertices, size_t quadsNumber)
+{
+	_voxelVertices.insert(std::end(_voxelVertices), vertices, vertices + 4 * quadsNumber);
+	_changed = true;
+	_uploadAll = true;
+}
+
+void
+VoxelMesh::ReserveQuads(size_t quadsNumber)
+{
+	_voxelVertices.reserve(4 * quadsNumber);
+}
+
+void
+VoxelMesh::ClearVertices()
+{
+	Mesh::ClearVertices();
+	_voxelVertices.clear();
+	_sliceEnds.clear();
+	_uploadAll = true;
+}
+
+void
+VoxelMesh::SwapVertices(VoxelMesh* other)
+{
+	_voxelVertices.swap(other->_voxelVertices);
+	_sliceEnds.swap(other->_sliceEnds);
+	std::swap(_voxelSize, other->_voxelSize);
+	std::swap(_voxelCenter, other->_voxelCenter);
+	_changed = true;
+	_uploadAll = true;
+	other->_changed = true;
+	other->_uploadAll = true;
+}
+
+void
+VoxelMesh::CopyVertices(const VoxelMesh& other)
+{
+	_voxelVertices = other._voxelVertices;
+	_sliceEnds = other._sliceEnds;
+	_voxelSize = other._voxelSize;
+	_voxelCenter = other._voxelCenter;
+	_changed = true;
+	_uploadAll = true;
+}
+
+void
+VoxelMesh::BeginSlices(int slicesNumber)
+{
+	assert(_voxelVertices.empty(), "Slices can be started only in empty mesh.");
+	_sliceEnds.assign(slicesNumber, 0);
+}
+
+void
+VoxelMesh::EndSlice(int slice)
+{
+	_sliceEnds[slice] = (uint32_t)GetQuadsNumber();
+}
+
+void
+VoxelMesh::ReplaceSlice(int slice, const VoxelVertex* vertices, size_t quadsNumber)
+{
+	assert(slice >= 0 && slice < (int)_sliceEnds.size(), "Wrong slice: %d.", slice);
+
+	size_t begin = 4 * (slice > 0 ? _sliceEnds[slice - 1] : 0);
+	size_t end = 4 * _sliceEnds[slice];
+	size_t count = 4 * quadsNumber;
+
+	/* Slices behind are moved when number of quads changes, so they must be uploaded too */
+	if (count != end - begin) {
+		_voxelVertices.erase(_voxelVertices.begin() + begin, _voxelVertices.begin() + end);
+		_voxelVertices.insert(_voxelVertices.begin() + begin, vertices, vertices + count);
+
+		int32_t delta = (int32_t)quadsNumber - (int32_t)((end - begin) / 4);
+		for (size_t i = slice; i < _sliceEnds.size(); ++i)
+			_sliceEnds[i] += delta;
+		end = _voxelVertices.size();
+	}
+	else {
+		std::copy(vertices, vertices + count, _voxelVertices.begin() + begin);
+	}
+
+	if (_dirtyBegin == _dirtyEnd) {
+		_dirtyBegin = begin;
+		_dirtyEnd = end;
+	}
+	else {
+		_dirtyBegin = std::min(_dirtyBegin, begin);
+		_dirtyEnd = std::max(_dirtyEnd, end);
+	}
+	_changed = true;
+}
+
+void
+VoxelMesh::UpdateVertexBuffer()
+{
+	size_t size = _voxelVertices.size() * sizeof(VoxelVertex);
+
+	/* After replacing slices only changed vertices are sent, if they still fit into the buffer */
+	if (!_uploadAll && size <= (size_t)_vbo.GetSize()) {
+		if (_dirtyEnd > _dirtyBegin)
+			_vbo.ChangeData(_dirtyBegin * sizeof(VoxelVertex), _voxelVertices.data() + _dirtyBegin, (_dirtyEnd - _dirtyBegin) * sizeof(VoxelVertex));
+	}
+	/* Buffer is as big as the capacity of the vertices, so slices can grow a bit without allocating it again */
+	else {
+		_vbo.ReserveMutableSizeData(nullptr, _voxelVertices.capacity() * sizeof(VoxelVertex), GlBuffer::DYNAMIC_DRAW);
+		_vbo.ChangeData(0, _voxelVertices.data(), size);
+	}
+
+	_dirtyBegin = 0;
+	_dirtyEnd = 0;
+	_uploadAll = false;
+}
+
+void
+VoxelMesh::UpdateIndexBuffer()
+{
+	/* Indices are not stored, shared buffer must only be big enough */
+	ReserveQuadIndices(GetQuadsNumber());
+}
+
+void
+VoxelMesh::BindIndexBuffer()
+{
+	_quadIndices.Bind(GlBuffer::INDICES);
+}
+
+void
+VoxelMesh::ReserveQuadIndices(size_t quadsNumber)
+{
+	if (quadsNumber <= _quadIndicesCapacity)
+		return;
+
+	if (!_quadIndices.IsValid())
+		_quadIndices.Init();
+
+	/* Grow geometrically, so buffer is rebuilt only few times while the world is loading */
+	size_t capacity = std::max(quadsNumber, 2 * _quadIndicesCapacity);
+	std::vector<GLuint> indices(6 * capacity);
+	VoxelVertex::FillQuadIndices(indices.data(), 0, (uint32_t)capacity);
+	_quadIndices.ReserveMutableSizeData(indices.data(), indices.size() * sizeof(GLuint), GlBuffer::STATIC_DRAW);
+	_quadIndicesCapacity = capacity;
+}
+
+void
+VoxelMesh::DeleteQuadIndices()
+{
+	_quadIndices.Delete();
+	_quadIndicesCapacity = 0;
+}
 
 void 
 VoxelMesh::ActivateAttributes()
 {
-	Mesh::ActivateAttributes();
-	_vao.ActivateBinded(ATLAS_OFFSET, 2, GL_INT, sizeof(Vertex), (GLvoid*)offsetof(Vertex, atlasOffset));
+	/* Packed words are read as integers and decoded in the Voxel shader */
+	_vao.ActivateBindedInteger(POSITION, 1, GL_UNSIGNED_INT, sizeof(VoxelVertex), (GLvoid*)offsetof(VoxelVertex, position));
+	_vao.ActivateBindedInteger(TEXTURE, 1, GL_UNSIGNED_INT, sizeof(VoxelVertex), (GLvoid*)offsetof(VoxelVertex, texture));
 }
 
 void 
@@ -16,6 +186,7 @@ VoxelMesh::FillInfo(RenderInfo* info)
 {
 	_tex = _atlas;
 	Mesh::FillInfo(info);
+	info->indicesNumber = (GLuint)(6 * GetQuadsNumber());
 }
 
 void 
@@ -24,6 +195,7 @@ VoxelMesh::Draw(Renderer* renderer)
 	RenderInfo info;
 
 	DrawStart(&info);
+	renderer->SetVoxelTransform(_voxelSize, _voxelCenter);
 	renderer->Draw(info, Renderer::VOXEL);
 	DrawEnd();
 }
@@ -48,4 +220,4 @@ VoxelMesh::GetAtlas()
 }
 
 
-}
\ No newline at end of file
+}
@@ -1,27 +1,112 @@
 #pragma once
 
 #include "Mesh.h"
+#include "Engine/VoxelVertex.h"
 
 namespace vengine {
 
+typedef std::vector<VoxelVertex> VoxelVertices;
+
 /*
 * Special mesh object, that is using global atlas and is mapping textures in special way on quads.
 * UV's are mapped in special way to repeat one given type of the texture in whole quad. 
+* Vertices are stored packed, positions are restored in the shader using voxel size and center of the mesh.
+* Mesh is made only of quads, so it is not storing indices - all voxel meshes are drawn with one shared index buffer.
+* Quads can be grouped into slices, which can be replaced separately. Then only changed part of the buffer is uploaded.
 */
 class VoxelMesh : public Mesh
 {
 public:
+	VoxelMesh();
+
 	virtual void Draw(Renderer* renderer);
 
+	/* Deletes all resources */
+	virtual void Delete();
+
+	/* Get packed vertices stored in the mesh */
+	const VoxelVertices& GetVertices();
+
+	/* Get number of quads in the mesh */
+	size_t GetQuadsNumber() const;
+
+	/* Add quads given as 4 following vertices each. Mesh will be marked as changed. */
+	void AddQuads(const VoxelVertex* vertices, size_t quadsNumber);
+	/* Reserve space for quads. Cleared mesh is keeping its memory, so it is needed only when it grows. */
+	void ReserveQuads(size_t quadsNumber);
+	/* Delete all vertices from the mesh. */
+	virtual void ClearVertices();
+	/* Exchange vertices with other mesh, used for taking vertices generated outside of the main thread without copying */
+	void SwapVertices(VoxelMesh* other);
+	/* Copy vertices, slices and transform of other mesh */
+	void CopyVertices(const VoxelMesh& other);
+
+	/* Start dividing quads into given number of slices, mesh must be empty */
+	void BeginSlices(int slicesNumber);
+	/* Mark end of the slice, all quads added since the end of the previous slice belong to it. Slices must be ended in order. */
+	void EndSlice(int slice);
+	/* Check if mesh is divided into given number of slices */
+	bool HasSlices(int slicesNumber) const;
+	/* Replace quads of the slice with given ones */
+	void ReplaceSlice(int slice, const VoxelVertex* vertices, size_t quadsNumber);
+
+	/* Set size of the voxel and center of the voxel array, packed grid positions are scaled and moved by them */
+	void SetTransform(float voxelSize, const Vector3& center);
+
 	static void SetAtlas(unsigned int atlas);
 	static void SetAtlas(const std::string& name);
 	static unsigned int GetAtlas();
 
+	/* Delete index buffer shared by all voxel meshes, it must be called before destroying OpenGL context */
+	static void DeleteQuadIndices();
+
 protected:
 	static unsigned int _atlas;
 
+	static GlBuffer _quadIndices;			/* Index buffer shared by all voxel meshes */
+	static size_t _quadIndicesCapacity;		/* Number of quads covered by the shared index buffer */
+
+	/* Grow shared index buffer if it does not cover given number of quads */
+	static void ReserveQuadIndices(size_t quadsNumber);
+
+	VoxelVertices _voxelVertices;	/* Packed vertices of the mesh */
+	std::vector<uint32_t> _sliceEnds;	/* Index of the quad after the last quad of each slice, empty if mesh is not divided */
+	size_t _dirtyBegin;				/* First vertex changed since last upload */
+	size_t _dirtyEnd;				/* Vertex after the last one changed since last upload */
+	bool _uploadAll;				/* Whole buffer must be uploaded, not only changed vertices */
+	float _voxelSize;				/* Size of each voxel in world units */
+	Vector3 _voxelCenter;			/* Center of the voxel array in world units */
+
+	virtual void UpdateVertexBuffer();
+	virtual void UpdateIndexBuffer();
+	virtual void BindIndexBuffer();
 	virtual void ActivateAttributes();
 	virtual void FillInfo(RenderInfo* info);
 };
 
-}
\ No newline at end of file
+inline const VoxelVertices&
+VoxelMesh::GetVertices()
+{
+	return _voxelVertices;
+}
+
+inline size_t
+VoxelMesh::GetQuadsNumber() const
+{
+	return _voxelVertices.size() / 4;
+}
+
+inline bool
+VoxelMesh::HasSlices(int slicesNumber) const
+{
+	return _sliceEnds.size() == (size_t)slicesNumber;
+}
+
+inline void
+VoxelMesh::SetTransform(float voxelSize, const Vector3& center)
+{
+	_voxelSize = voxelSize;
+	_voxelCenter = center;
+}
+
+}
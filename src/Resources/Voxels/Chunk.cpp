@@ -3,50 +3,51 @@
 namespace vengine {
 
 
-Chunk::Chunk() : _offset(Vector3::zeroes)
+template <int N>
+BasicChunk<N>::BasicChunk() : _offset(Vector3::zeroes)
 {
-	VoxelArray3D::Init("Chunk" + _offset.ToString(), dimension, dimension, dimension);
+	VoxelArray3D::InitDimension("Chunk" + _offset.ToString(), dimension, dimension, dimension);
+	_storage.Init(_numElements);
 	_changed = false;
+	_edited = false;
+	_changedBorders = 0;
+	SetChangedLayers(false);
 	_model = Matrix4::GetTranslate(_center);
-	_constraintHigh = _offset + (float)(Chunk::dimension - 1);
+	_constraintHigh = _offset + (float)(dimension - 1);
 }
 
-Chunk::Chunk(const Vector3& offset) : _offset(offset)
+template <int N>
+BasicChunk<N>::BasicChunk(const Vector3& offset) : _offset(offset)
 {
-	VoxelArray3D::Init("Chunk" + _offset.ToString(), dimension, dimension, dimension);
+	VoxelArray3D::InitDimension("Chunk" + _offset.ToString(), dimension, dimension, dimension);
+	_storage.Init(_numElements);
 	_changed = false;
+	_edited = false;
+	_changedBorders = 0;
+	SetChangedLayers(false);
 	_model = Matrix4::GetTranslate(offset + _center);
-	_constraintHigh = _offset + (float)(Chunk::dimension - 1);
+	_constraintHigh = _offset + (float)(dimension - 1);
 }
 
+template <int N>
 void
-Chunk::SetOffset(const Vector3& offset)
+BasicChunk<N>::SetOffset(const Vector3& offset)
 {
 	_offset = offset;
 	_model = Matrix4::GetTranslate(_offset + _center);
-	_constraintHigh = _offset + (float)(Chunk::dimension - 1);
+	_constraintHigh = _offset + (float)(dimension - 1);
 }
 
+template <int N>
 const Matrix4&
-Chunk::GetModelMatrix()
+BasicChunk<N>::GetModelMatrix()
 {
 	return _model;
 }
 
+template <int N>
 void
-Chunk::SetLocal(int x, int y, int z, unsigned char type)
-{
-	int index = x + dimension*(y + dimension*z);
-	assert(index < _numElements, "Index out of range: %d / %d elements.", index, _numElements);
-	_voxels[index] = type;
-
-	_changed = true;
-	if (_empty && type != Voxel::NONE)
-		_empty = false;
-}
-
-void
-Chunk::Set(const Vector3& coordinates, unsigned char type)
+BasicChunk<N>::Set(const Vector3& coordinates, unsigned char type)
 {
 	int x = int(coordinates.x - _offset.x);
 	assert(x < dimension && x >= 0, "X out of range: %d / %d dimension.", x, dimension);
@@ -58,18 +59,9 @@ Chunk::Set(const Vector3& coordinates, unsigned char type)
 	SetLocal(x, y, z, type);
 }
 
-const Voxel&
-Chunk::GetLocal(int x, int y, int z) const
-{
-
-	assert(x < dimension && x >= 0, "X out of range: %d / %d dimension.", x, dimension);
-	assert(y < dimension && y >= 0, "Y out of range: %d / %d dimension.", y, dimension);
-	assert(z < dimension && z >= 0, "Z out of range: %d / %d dimension.", z, dimension);
-	return VoxelArray3D::Get(x, y, z);
-}
-
-const Voxel&
-Chunk::Get(const Vector3& coordinates)
+template <int N>
+Voxel
+BasicChunk<N>::Get(const Vector3& coordinates)
 {
 	int x = (int)floor(coordinates.x - _offset.x);
 	assert(x < dimension && x >= 0, "X out of range: %d / %d dimension.", x, dimension);
@@ -81,41 +73,360 @@ Chunk::Get(const Vector3& coordinates)
 	return GetLocal(x, y, z);
 }
 
+template <int N>
 const Vector3&
-Chunk::GetOffset()
+BasicChunk<N>::GetOffset()
 {
 	return _offset;
 }
 
+template <int N>
 const std::string&
-Chunk::GetName() const
+BasicChunk<N>::GetName() const
 {
 	return VoxelArray3D::GetName();
 }
 
+template <int N>
+float
+BasicChunk<N>::GetVoxelSize() const
+{
+	return VoxelArray3D::GetVoxelSize();
+}
+
+template <int N>
+uint64_t
+BasicChunk<N>::GetContentHash() const
+{
+	return _storage.GetHash();
+}
+
+template <int N>
 const Vector3& 
-Chunk::GetCenter()
+BasicChunk<N>::GetCenter()
 {
 	return VoxelArray3D::GetCenter();
 }
 
+template <int N>
 bool
-Chunk::HasChanged()
+BasicChunk<N>::HasChanged()
 {
 	return _changed;
 }
 
+template <int N>
 bool
-Chunk::IsEmpty()
+BasicChunk<N>::IsEmpty()
+{
+	return GetSolidCount() == 0;
+}
+
+template <int N>
+void
+BasicChunk<N>::Invalidate()
+{
+	_changed = true;
+	SetChangedLayers(true);
+}
+
+template <int N>
+void
+BasicChunk<N>::InvalidateFace(int dir, bool front)
 {
-	return VoxelArray3D::IsEmpty();
+	assert(dir >= 0 && dir < 3, "Wrong direction: %d", dir);
+	_changed = true;
+	_changedLayers[dir] |= (Row)((Row)1 << (front ? N - 1 : 0));
 }
 
+template <int N>
 void
-Chunk::GenerateMesh(VoxelMesh* mesh)
+BasicChunk<N>::Validate()
 {
 	_changed = false;
-	VoxelArray3D::GenerateMesh(mesh);
+	_changedBorders = 0;
+	SetChangedLayers(false);
 }
 
+template <int N>
+void
+BasicChunk<N>::SetChangedLayers(bool changed)
+{
+	Row layers = changed ? OccupancyMask<N>::RangeMask(0, N - 1) : (Row)0;
+	for (int i = 0; i < 3; ++i)
+		_changedLayers[i] = layers;
+}
+
+template <int N>
+uint8_t
+BasicChunk<N>::GetChangedBorders() const
+{
+	return _changedBorders;
+}
+
+template <int N>
+void
+BasicChunk<N>::Fill(unsigned char type)
+{
+	_storage.Fill(type);
+	_occupancy.Clear();
+	_changed = true;
+	_changedBorders = 0x3f;
+	SetChangedLayers(true);
+	_empty = (type == Voxel::NONE);
+}
+
+template <int N>
+void
+BasicChunk<N>::GetFaceMask(int dir, bool front, Row rows[N]) const
+{
+	if (IsUniform()) {
+		Voxel voxel = GetUniformVoxel();
+		Row row = (!voxel.IsEmpty() && !voxel.IsTransparent()) ? OccupancyMask<N>::RangeMask(0, N - 1) : (Row)0;
+		for (int i = 0; i < N; ++i)
+			rows[i] = row;
+		return;
+	}
+
+	int u = (dir + 1) % 3;
+	int v = (dir + 2) % 3;
+	int coords[3];
+	coords[dir] = front ? N - 1 : 0;
+
+	for (coords[v] = 0; coords[v] < N; ++coords[v]) {
+		Row row = 0;
+		for (coords[u] = 0; coords[u] < N; ++coords[u]) {
+			/* Only solid voxels have to be decoded to check transparency */
+			if (_occupancy.Get(coords[0], coords[1], coords[2]) && !GetLocal(coords[0], coords[1], coords[2]).IsTransparent())
+				row |= (Row)((Row)1 << coords[u]);
+		}
+		rows[coords[v]] = row;
+	}
+}
+
+template <int N>
+void
+BasicChunk<N>::GenerateMesh(VoxelMesh* mesh, Mesher mesher)
+{
+	/* Without neighbours all faces on the edges are visible */
+	GenerateMesh(mesh, Border(), mesher);
+}
+
+template <int N>
+void
+BasicChunk<N>::GenerateMesh(VoxelMesh* mesh, const Border& border, Mesher mesher)
+{
+	_changed = false;
+	_changedBorders = 0;
+	SetChangedLayers(false);
+
+	if (IsUniform()) {
+		Voxel voxel = GetUniformVoxel();
+
+		/* There is nothing to draw */
+		if (voxel.IsEmpty()) {
+			mesh->ClearVertices();
+			_empty = true;
+			return;
+		}
+
+		/* All inner faces of opaque chunk are hidden, only the outer shell is visible */
+		if (!voxel.IsTransparent()) {
+			/* Faces completely covered by neighbours are skipped, partially covered ones must be meshed */
+			const Row full = OccupancyMask<N>::RangeMask(0, N - 1);
+			uint8_t hidden = 0;
+			bool partial = false;
+			for (int front = 0; front < 2; ++front) {
+				for (int dir = 0; dir < 3; ++dir) {
+					Row all = full;
+					Row any = 0;
+					for (int i = 0; i < N; ++i) {
+						all &= border.GetRow(dir, front != 0, i);
+						any |= border.GetRow(dir, front != 0, i);
+					}
+
+					if (all == full)
+						hidden |= 1 << (dir + 3 * front);
+					else if (any != 0)
+						partial = true;
+				}
+			}
+
+			if (!partial) {
+				VoxelArray3D::GenerateShell(voxel, mesh, hidden);
+				return;
+			}
+		}
+	}
+
+	/* Mesher is working on plain voxels, so decode them first. Buffer is reused by all chunks meshed on this thread. */
+	static thread_local std::vector<Voxel> voxels;
+	voxels.resize(_numElements);
+	_storage.Unpack(voxels.data());
+	if (mesher != BINARY) {
+		VoxelArray3D::GenerateMesh(Dimension(), border, voxels.data(), mesh);
+		return;
+	}
+
+	/* Binary mesher takes solid voxels from the occupancy mask, uniform chunk is not keeping it */
+	static thread_local std::vector<Row> solidRows;
+	const Row* solid;
+	if (_occupancy.IsAllocated()) {
+		solid = _occupancy.GetRows();
+	}
+	else {
+		solidRows.assign(N * N, GetUniformVoxel().IsEmpty() ? (Row)0 : OccupancyMask<N>::RangeMask(0, N - 1));
+		solid = solidRows.data();
+	}
+
+	/* Transparency is checked only for solid voxels and only if the palette contains transparent type */
+	bool transparent = false;
+	for (int i = 0; i < _storage.GetPaletteSize() && !transparent; ++i)
+		transparent = Voxel(_storage.GetPaletteType(i)).IsTransparent();
+
+	static thread_local std::vector<Row> opaqueRows;
+	const Row* opaque = solid;
+	if (transparent) {
+		opaqueRows.resize(N * N);
+		for (int i = 0; i < N * N; ++i) {
+			Row row = solid[i];
+			Row remaining = row;
+			while (remaining != 0) {
+				int x = bitScanForward(remaining);
+				remaining &= (Row)(remaining - 1);
+				if (voxels[x + N * i].IsTransparent())
+					row &= (Row)~((Row)1 << x);
+			}
+			opaqueRows[i] = row;
+		}
+		opaque = opaqueRows.data();
+	}
+
+	VoxelArray3D::GenerateBinaryMesh<N>(border, voxels.data(), solid, opaque, mesh);
+}
+
+template <int N>
+bool
+BasicChunk<N>::CanUpdateMesh(const VoxelMesh* mesh) const
+{
+	/* Slices are kept only by the binary mesher, uniform chunks are meshed in other way */
+	if (IsUniform() || !mesh->HasSlices(6 * N))
+		return false;
+
+	/* Invalidated chunk could have different border, so all slices must be generated again */
+	const Row all = OccupancyMask<N>::RangeMask(0, N - 1);
+	for (int dir = 0; dir < 3; ++dir) {
+		if (_changedLayers[dir] == all)
+			return false;
+	}
+	return true;
+}
+
+template <int N>
+void
+BasicChunk<N>::UpdateMesh(VoxelMesh* mesh, const Border& border)
+{
+	if (!CanUpdateMesh(mesh)) {
+		GenerateMesh(mesh, border);
+		return;
+	}
+
+	const Row all = OccupancyMask<N>::RangeMask(0, N - 1);
+
+	static thread_local std::vector<Voxel> voxels;
+	voxels.resize(_numElements);
+	_storage.Unpack(voxels.data());
+
+	for (int dir = 0; dir < 3; ++dir) {
+		/* Faces of the layer depend on the voxels of the next layer in their direction */
+		Row changed = _changedLayers[dir];
+		Row layers[2] = { (Row)((changed | (changed << 1)) & all), (Row)(changed | (changed >> 1)) };
+
+		for (int front = 0; front < 2; ++front) {
+			Row remaining = layers[front];
+			while (remaining != 0) {
+				int layer = bitScanForward(remaining);
+				remaining &= (Row)(remaining - 1);
+				VoxelArray3D::UpdateBinarySlice<N>(border, voxels.data(), dir, front != 0, layer, mesh);
+			}
+		}
+	}
+
+	_changed = false;
+	_changedBorders = 0;
+	SetChangedLayers(false);
+	if (mesh->GetQuadsNumber() == 0)
+		_empty = true;
+}
+
+template <int N>
+void
+BasicChunk<N>::GenerateLodMesh(VoxelMesh* mesh, int lod)
+{
+	assert(lod > 0 && lod <= lodLevels, "Wrong level of detail: %d.", lod);
+
+	const int factor = 1 << lod;
+	const int cells = N >> lod;
+
+	static thread_local std::vector<Voxel> voxels;
+	static thread_local std::vector<Voxel> coarse;
+	voxels.resize(_numElements);
+	_storage.Unpack(voxels.data());
+	coarse.assign(cells * cells * cells, Voxel());
+
+	Dimension dim;
+	for (int cz = 0; cz < cells; ++cz) {
+		for (int cy = 0; cy < cells; ++cy) {
+			for (int cx = 0; cx < cells; ++cx) {
+				/* Count types inside the cell, opaque ones are preferred over transparent */
+				int counts[256] = {};
+				int best = Voxel::NONE;
+				int bestScore = 0;
+				for (int z = cz * factor; z < (cz + 1) * factor; ++z) {
+					for (int y = cy * factor; y < (cy + 1) * factor; ++y) {
+						for (int x = cx * factor; x < (cx + 1) * factor; ++x) {
+							const Voxel& voxel = voxels[dim.Index(x, y, z)];
+							if (voxel.IsEmpty())
+								continue;
+
+							unsigned char type = voxel.GetType();
+							int score = ++counts[type] + (voxel.IsTransparent() ? 0 : factor * factor * factor);
+							if (score > bestScore) {
+								bestScore = score;
+								best = type;
+							}
+						}
+					}
+				}
+
+				coarse[cx + cells * (cy + cells * cz)] = Voxel((unsigned char)best);
+			}
+		}
+	}
+
+	/* Coarse chunk is meshed without neighbours, so its outer faces are closing gaps to neighbours with finer detail */
+	VoxelArray3D::GenerateMesh(RuntimeDimension(cells, cells, cells), NoBorder(), coarse.data(), mesh);
+	mesh->SetTransform(factor * _voxelSize, _center);
+}
+
+template <int N>
+void
+BasicChunk<N>::Compact()
+{
+	_storage.Compact();
+	if (_storage.IsUniform())
+		_occupancy.Clear();
+}
+
+template <int N>
+size_t
+BasicChunk<N>::GetMemoryUsage() const
+{
+	return _storage.GetMemoryUsage() + _occupancy.GetMemoryUsage();
+}
+
+template class BasicChunk<16>;
+template class BasicChunk<32>;
+template class BasicChunk<64>;
+
 }
\ No newline at end of file
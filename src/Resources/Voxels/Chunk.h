@@ -1,28 +1,54 @@
 #pragma once
 
 #include "VoxelArray3D.h"
+#include "PaletteStorage.h"
+#include "OccupancyMask.h"
+#include "VoxelBorder.h"
 #include "Math/Matrix4.h"
 
 namespace vengine {
 
-/* Extension of Voxel Array. It is cube, name is generated according to position and can be modified at the runtime. */
-class Chunk : private VoxelArray3D {
+/* Edge length of the chunks used by the world. It can be overriden in project settings to 32 or 64. */
+#ifndef VE_CHUNK_DIMENSION
+#define VE_CHUNK_DIMENSION 16
+#endif
+
+/*
+* Extension of Voxel Array. It is cube, name is generated according to position and can be modified at the runtime.
+* Voxels are not stored in the array, but in palette storage, because chunks usually contain only few types.
+* Edge length N is known at compile time and must be power of two, so indexing is done with shifts.
+* Available instances are BasicChunk<16>, BasicChunk<32> and BasicChunk<64>.
+* Next to the types, chunk keeps occupancy mask of the solid voxels, so collisions can test whole rows at once.
+*/
+template <int N>
+class BasicChunk : private VoxelArray3D {
 public:
-	Chunk();
-	Chunk(const Vector3& offset);
+	/* Bits of the voxels in one row of the occupancy mask */
+	typedef typename OccupancyMask<N>::Row Row;
+	/* Opaque voxels of the neighbours lying next to the chunk faces */
+	typedef ChunkBorder<N> Border;
+
+	/* Algorithms used for generating mesh of the chunk */
+	enum Mesher {
+		GREEDY,	/* Greedy meshing comparing voxels one by one */
+		BINARY	/* Greedy meshing working on whole rows of voxels stored as bits */
+	};
+
+	BasicChunk();
+	BasicChunk(const Vector3& offset);
 
 	/* Set offset in world coordinates. This way we can spare some space by not storing offset in each voxel. */
 	void SetOffset(const Vector3& offset);
 
-	/* Set voxel using local chunk coordinates */
+	/* Set voxel using local chunk coordinates. Chunk is not marked as changed if the voxel already has given type. */
 	void SetLocal(int x, int y, int z, unsigned char type);
 	/* Set voxel using world coordinates */
 	void Set(const Vector3& coordinates, unsigned char type);
 
 	/* Get voxel using local chunk coordinates */
-	const Voxel& GetLocal(int x, int y, int z) const;
+	Voxel GetLocal(int x, int y, int z) const;
 	/* Get voxel using world coordinates*/
-	const Voxel& Get(const Vector3& coordinates);
+	Voxel Get(const Vector3& coordinates);
 
 	/* Check if point is inside chunk. */
 	bool IsInside(const Vector3& coordinates);
@@ -32,29 +58,274 @@ public:
 	/* Center of the chunk */
 	const Vector3& GetCenter();
 	const std::string& GetName() const;
+	float GetVoxelSize() const;
+	/* Get hash of the types of all voxels. Chunks with the same voxels have the same hash, wherever they are placed. */
+	uint64_t GetContentHash() const;
+
+	/* Set all voxels in the chunk to the given type. Chunk will become uniform. */
+	void Fill(unsigned char type);
 
 	/* Check if chunk has changed since last mesh generation */
 	bool HasChanged();
+	/* Mark chunk as changed, so its mesh will be generated again. Used when neighbour has changed. */
+	void Invalidate();
+	/* Mark chunk as changed, because neighbour lying next to given face has changed. Only faces on that side will be meshed again. */
+	void InvalidateFace(int dir, bool front);
+	/* Mark chunk and its faces as not changed. Used when mesh is generated from the copy of the chunk. */
+	void Validate();
+	/* Get faces which voxels changed since last mesh generation, bit (dir + 3 * front) is set for changed face */
+	uint8_t GetChangedBorders() const;
+	/* Mark chunk as edited by the player, so it must not be replaced with the generated one */
+	void MarkEdited();
+	/* Check if chunk has been edited by the player since it was generated */
+	bool IsEdited() const;
 	/* Check if voxel have all NONE voxels */
 	bool IsEmpty();
+	/* Check if all voxels in the chunk have the same type. Uniform chunks are not storing voxel array. */
+	bool IsUniform() const;
+	/* Get voxel that is filling whole uniform chunk */
+	Voxel GetUniformVoxel() const;
 
-	/* Generate mesh for the chunk */
-	void GenerateMesh(VoxelMesh* mesh);
+	/* Check if voxel is solid using local chunk coordinates */
+	bool IsSolidLocal(int x, int y, int z) const;
+	/* Check if voxel is solid using world coordinates */
+	bool IsSolid(const Vector3& coordinates) const;
+	/* Check if there is at least one solid voxel in the box given with inclusive local coordinates */
+	bool AnySolid(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) const;
+	/* Get local coordinate of the first solid voxel going from (x, y, z) along axis to end (inclusive) or -1 if there is none */
+	int FirstSolid(int x, int y, int z, int axis, int end) const;
+	/* Get solid voxels in the row along X axis, bit x is set for solid voxel */
+	Row GetRowMask(int y, int z) const;
+	/* Get solid voxels in the column along Y axis, bit y is set for solid voxel */
+	Row GetColumnMask(int x, int z) const;
+	/* Get number of solid voxels in the chunk */
+	int GetSolidCount() const;
+
+	/* Get opaque voxels lying on the face of the chunk, rows have the same layout as layers of the Border */
+	void GetFaceMask(int dir, bool front, Row rows[N]) const;
+
+	/* Generate mesh for the chunk. Both meshers are giving the same result, binary one is much faster. */
+	void GenerateMesh(VoxelMesh* mesh, Mesher mesher = BINARY);
+	/* Generate mesh for the chunk, faces covered by opaque voxels of the neighbours are skipped */
+	void GenerateMesh(VoxelMesh* mesh, const Border& border, Mesher mesher = BINARY);
+	/*
+	* Update mesh generated earlier from this chunk. Only slices lying on the layers changed since then are generated again,
+	* so single voxel edit is touching at most 4 slices on each axis. Whole mesh is generated if it cannot be updated.
+	*/
+	void UpdateMesh(VoxelMesh* mesh, const Border& border);
+	/* Check if UpdateMesh can update given mesh without generating it again */
+	bool CanUpdateMesh(const VoxelMesh* mesh) const;
+	/*
+	* Generate mesh of the chunk downsampled 2^lod times on each axis, lod must be in range [1, lodLevels].
+	* Coarse cell is solid if any of its voxels is solid, so coarse mesh is covering the full one and no holes
+	* appear next to chunks drawn with other level of detail. Cell gets the most common opaque type of its voxels.
+	*/
+	void GenerateLodMesh(VoxelMesh* mesh, int lod);
 	/* Get model matrix of the chunk */
 	const Matrix4& GetModelMatrix();
 
-	static const int dimension = 16;
+	/* Remove unused types from the palette and shrink storage, chunk with one type will become uniform. Should be called after filling the chunk. */
+	void Compact();
+	/* Get number of bytes used for storing voxels */
+	size_t GetMemoryUsage() const;
+
+	static const int dimension = N;
+	/* Number of coarse levels of detail, the last one is downsampling chunk 8 times */
+	static const int lodLevels = 3;
 private:
+	typedef FixedDimension<N> Dimension;
+
 	bool _changed;			/* Check if chunk changed since last mesh generation */
+	bool _edited;			/* Chunk has been edited by the player since it was generated */
+	uint8_t _changedBorders;	/* Faces which voxels changed since last mesh generation, neighbours must be meshed again */
+	Row _changedLayers[3];	/* Layers of the voxels on each axis changed since last mesh generation, bit is set for changed layer */
 	Vector3 _offset;		 /* Offset of the chunk in the world coordinates. Left lower corner. */
 	Vector3 _constraintHigh; /* Maximum world coordinates that will not exceed chunk coordinates */
 
 	Matrix4 _model;		/* Model matrix of the chunk */
+
+	PaletteStorage _storage;		/* Types of the voxels */
+	OccupancyMask<N> _occupancy;	/* Solid voxels, not allocated when chunk is uniform */
+
+	/* Check if whole uniform chunk is solid */
+	bool IsUniformSolid() const;
+	/* Mark all layers as changed or not changed */
+	void SetChangedLayers(bool changed);
 };
 
+/* Chunk used by the world */
+typedef BasicChunk<VE_CHUNK_DIMENSION> Chunk;
+
+template <int N>
+inline void
+BasicChunk<N>::SetLocal(int x, int y, int z, unsigned char type)
+{
+	assert(x < dimension && x >= 0, "X out of range: %d / %d dimension.", x, dimension);
+	assert(y < dimension && y >= 0, "Y out of range: %d / %d dimension.", y, dimension);
+	assert(z < dimension && z >= 0, "Z out of range: %d / %d dimension.", z, dimension);
+
+	/* Writing the same type again must not cause meshing of the chunk and its neighbours */
+	int index = Dimension().Index(x, y, z);
+	if (_storage.Get(index) == type)
+		return;
+
+	bool wasUniform = _storage.IsUniform();
+	bool wasSolid = wasUniform && IsUniformSolid();
+	_storage.Set(index, type);
+
+	/* Voxels on the faces are used by neighbours */
+	if (x == 0)
+		_changedBorders |= 1 << 0;
+	else if (x == N - 1)
+		_changedBorders |= 1 << 3;
+	if (y == 0)
+		_changedBorders |= 1 << 1;
+	else if (y == N - 1)
+		_changedBorders |= 1 << 4;
+	if (z == 0)
+		_changedBorders |= 1 << 2;
+	else if (z == N - 1)
+		_changedBorders |= 1 << 5;
+	_changedLayers[0] |= (Row)((Row)1 << x);
+	_changedLayers[1] |= (Row)((Row)1 << y);
+	_changedLayers[2] |= (Row)((Row)1 << z);
+
+	/* Occupancy is needed only when chunk stops being uniform, start with the state of the previous type */
+	if (!_storage.IsUniform()) {
+		if (wasUniform)
+			_occupancy.Fill(wasSolid);
+		_occupancy.Set(x, y, z, type != Voxel::NONE);
+	}
+
+	_changed = true;
+	if (_empty && type != Voxel::NONE)
+		_empty = false;
+}
+
+template <int N>
+inline Voxel
+BasicChunk<N>::GetLocal(int x, int y, int z) const
+{
+	assert(x < dimension && x >= 0, "X out of range: %d / %d dimension.", x, dimension);
+	assert(y < dimension && y >= 0, "Y out of range: %d / %d dimension.", y, dimension);
+	assert(z < dimension && z >= 0, "Z out of range: %d / %d dimension.", z, dimension);
+	return Voxel(_storage.Get(Dimension().Index(x, y, z)));
+}
+
+template <int N>
+inline bool
+BasicChunk<N>::IsUniform() const
+{
+	return _storage.IsUniform();
+}
+
+template <int N>
+inline Voxel
+BasicChunk<N>::GetUniformVoxel() const
+{
+	return Voxel(_storage.GetUniformType());
+}
+
+template <int N>
+inline void
+BasicChunk<N>::MarkEdited()
+{
+	_edited = true;
+}
+
+template <int N>
+inline bool
+BasicChunk<N>::IsEdited() const
+{
+	return _edited;
+}
+
+template <int N>
+inline bool
+BasicChunk<N>::IsUniformSolid() const
+{
+	return _storage.GetUniformType() != Voxel::NONE;
+}
+
+template <int N>
+inline bool
+BasicChunk<N>::IsSolidLocal(int x, int y, int z) const
+{
+	assert(x < dimension && x >= 0, "X out of range: %d / %d dimension.", x, dimension);
+	assert(y < dimension && y >= 0, "Y out of range: %d / %d dimension.", y, dimension);
+	assert(z < dimension && z >= 0, "Z out of range: %d / %d dimension.", z, dimension);
+	if (IsUniform())
+		return IsUniformSolid();
+
+	return _occupancy.Get(x, y, z);
+}
+
+template <int N>
+inline bool
+BasicChunk<N>::IsSolid(const Vector3& coordinates) const
+{
+	return IsSolidLocal((int)floor(coordinates.x - _offset.x), (int)floor(coordinates.y - _offset.y), (int)floor(coordinates.z - _offset.z));
+}
+
+template <int N>
+inline bool
+BasicChunk<N>::AnySolid(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) const
+{
+	assert(minX >= 0 && minY >= 0 && minZ >= 0, "Box out of range: (%d, %d, %d)", minX, minY, minZ);
+	assert(maxX < dimension && maxY < dimension && maxZ < dimension, "Box out of range: (%d, %d, %d)", maxX, maxY, maxZ);
+	if (IsUniform())
+		return IsUniformSolid();
+
+	return _occupancy.Any(minX, minY, minZ, maxX, maxY, maxZ);
+}
+
+template <int N>
+inline int
+BasicChunk<N>::FirstSolid(int x, int y, int z, int axis, int end) const
+{
+	assert(axis >= 0 && axis < 3, "Wrong axis: %d", axis);
+	assert(end >= 0 && end < dimension, "End out of range: %d / %d dimension.", end, dimension);
+	if (IsUniform()) {
+		int coords[3] = { x, y, z };
+		return IsUniformSolid() ? coords[axis] : -1;
+	}
+
+	return _occupancy.First(x, y, z, axis, end);
+}
+
+template <int N>
+inline typename BasicChunk<N>::Row
+BasicChunk<N>::GetRowMask(int y, int z) const
+{
+	if (IsUniform())
+		return IsUniformSolid() ? OccupancyMask<N>::RangeMask(0, N - 1) : (Row)0;
+
+	return _occupancy.GetRow(y, z);
+}
+
+template <int N>
+inline typename BasicChunk<N>::Row
+BasicChunk<N>::GetColumnMask(int x, int z) const
+{
+	if (IsUniform())
+		return IsUniformSolid() ? OccupancyMask<N>::RangeMask(0, N - 1) : (Row)0;
+
+	return _occupancy.GetColumn(x, z);
+}
+
+template <int N>
+inline int
+BasicChunk<N>::GetSolidCount() const
+{
+	if (IsUniform())
+		return IsUniformSolid() ? N * N * N : 0;
+
+	return _occupancy.GetCount();
+}
 
+template <int N>
 inline bool 
-Chunk::IsInside(const Vector3& coordinates)
+BasicChunk<N>::IsInside(const Vector3& coordinates)
 {
 	Vector3 coords(floor(coordinates.x), floor(coordinates.y), floor(coordinates.z));
 	return (between(coords.x, _offset.x, _constraintHigh.x) &&
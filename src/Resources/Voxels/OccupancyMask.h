@@ -0,0 +1,217 @@
+#pragma once
+
+#include "Math/MathFunctions.h"
+
+#include <vector>
+#include <stdint.h>
+
+namespace vengine {
+
+/* Type of the single row of the occupancy mask, it must hold one bit for each voxel along X */
+template <int N>
+struct OccupancyRow;
+
+template <>
+struct OccupancyRow<16> {
+	typedef uint16_t Type;
+};
+
+template <>
+struct OccupancyRow<32> {
+	typedef uint32_t Type;
+};
+
+template <>
+struct OccupancyRow<64> {
+	typedef uint64_t Type;
+};
+
+/*
+* Bitset of the solid voxels in the cubic grid with edge N. Each row along X axis is stored in one integer,
+* rows are ordered the same way as voxels: y + N * z. Thanks to that, whole row can be checked with single
+* bit operation instead of decoding voxels one by one.
+* Mask is allocated lazily, empty mask means that owner knows occupancy without it (e.g. uniform chunk).
+*/
+template <int N>
+class OccupancyMask {
+public:
+	typedef typename OccupancyRow<N>::Type Row;
+
+	OccupancyMask();
+
+	/* Allocate mask with all voxels solid or all empty */
+	void Fill(bool solid);
+	/* Release memory used by the mask */
+	void Clear();
+	/* Check if mask is allocated */
+	bool IsAllocated() const;
+
+	/* Mark voxel as solid or empty */
+	void Set(int x, int y, int z, bool solid);
+	/* Check if voxel is solid */
+	bool Get(int x, int y, int z) const;
+
+	/* Get bits of all voxels in the row along X axis */
+	Row GetRow(int y, int z) const;
+	/* Get bits of all voxels in the column along Y axis */
+	Row GetColumn(int x, int z) const;
+	/* Get all rows along X axis, ordered the same way as voxels. Mask must be allocated. */
+	const Row* GetRows() const;
+
+	/* Check if there is at least one solid voxel inside box given with inclusive coordinates */
+	bool Any(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) const;
+	/* Get coordinate of the first solid voxel going from (x, y, z) along axis to end (inclusive) or -1 if there is none */
+	int First(int x, int y, int z, int axis, int end) const;
+
+	/* Get number of solid voxels */
+	int GetCount() const;
+	/* Get number of bytes allocated for the mask */
+	size_t GetMemoryUsage() const;
+
+	/* Get row with bits set from 'from' to 'to' (inclusive) */
+	static Row RangeMask(int from, int to);
+
+private:
+	std::vector<Row> _rows; /* Rows along X axis, N * N of them */
+	int _count;				/* Number of solid voxels */
+};
+
+
+template <int N>
+inline
+OccupancyMask<N>::OccupancyMask() : _count(0)
+{
+}
+
+template <int N>
+inline void
+OccupancyMask<N>::Fill(bool solid)
+{
+	_rows.assign(N * N, solid ? (Row)~(Row)0 : (Row)0);
+	_count = solid ? N * N * N : 0;
+}
+
+template <int N>
+inline void
+OccupancyMask<N>::Clear()
+{
+	std::vector<Row>().swap(_rows);
+	_count = 0;
+}
+
+template <int N>
+inline bool
+OccupancyMask<N>::IsAllocated() const
+{
+	return !_rows.empty();
+}
+
+template <int N>
+inline void
+OccupancyMask<N>::Set(int x, int y, int z, bool solid)
+{
+	Row& row = _rows[y + N * z];
+	Row bit = (Row)((Row)1 << x);
+	if (solid == ((row & bit) != 0))
+		return;
+
+	row ^= bit;
+	_count += solid ? 1 : -1;
+}
+
+template <int N>
+inline bool
+OccupancyMask<N>::Get(int x, int y, int z) const
+{
+	return ((_rows[y + N * z] >> x) & 1) != 0;
+}
+
+template <int N>
+inline typename OccupancyMask<N>::Row
+OccupancyMask<N>::GetRow(int y, int z) const
+{
+	return _rows[y + N * z];
+}
+
+template <int N>
+inline const typename OccupancyMask<N>::Row*
+OccupancyMask<N>::GetRows() const
+{
+	return _rows.data();
+}
+
+template <int N>
+inline typename OccupancyMask<N>::Row
+OccupancyMask<N>::GetColumn(int x, int z) const
+{
+	Row column = 0;
+	const Row* rows = &_rows[N * z];
+	for (int y = 0; y < N; ++y)
+		column |= (Row)(((rows[y] >> x) & 1) << y);
+
+	return column;
+}
+
+template <int N>
+inline bool
+OccupancyMask<N>::Any(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) const
+{
+	Row mask = RangeMask(minX, maxX);
+	for (int z = minZ; z <= maxZ; ++z)
+		for (int y = minY; y <= maxY; ++y)
+			if (_rows[y + N * z] & mask)
+				return true;
+
+	return false;
+}
+
+template <int N>
+inline int
+OccupancyMask<N>::First(int x, int y, int z, int axis, int end) const
+{
+	int coords[3] = { x, y, z };
+	int start = coords[axis];
+
+	/* Along X whole range is inside one row */
+	if (axis == 0) {
+		Row row = _rows[y + N * z] & (start <= end ? RangeMask(start, end) : RangeMask(end, start));
+		if (row == 0)
+			return -1;
+
+		return start <= end ? bitScanForward(row) : bitScanReverse(row);
+	}
+
+	/* Along other axes only one bit of each row is tested */
+	int step = start <= end ? 1 : -1;
+	for (int d = start; d != end + step; d += step) {
+		coords[axis] = d;
+		if ((_rows[coords[1] + N * coords[2]] >> x) & 1)
+			return d;
+	}
+
+	return -1;
+}
+
+template <int N>
+inline int
+OccupancyMask<N>::GetCount() const
+{
+	return _count;
+}
+
+template <int N>
+inline size_t
+OccupancyMask<N>::GetMemoryUsage() const
+{
+	return _rows.capacity() * sizeof(Row);
+}
+
+template <int N>
+inline typename OccupancyMask<N>::Row
+OccupancyMask<N>::RangeMask(int from, int to)
+{
+	const Row full = (Row)~(Row)0;
+	return (Row)((Row)(full >> (N - 1 - to)) & (Row)(full << from));
+}
+
+}
@@ -0,0 +1,207 @@
+#include "PaletteStorage.h"
+#include "Math/MathFunctions.h"
+
+namespace vengine {
+
+PaletteStorage::PaletteStorage() : _numElements(0), _bitsShift(0), _mask(1)
+{
+}
+
+void
+PaletteStorage::Init(int numElements, unsigned char type)
+{
+	_numElements = numElements;
+	Fill(type);
+}
+
+void
+PaletteStorage::Fill(unsigned char type)
+{
+	_palette.assign(1, type);
+	std::vector<Word>().swap(_words);
+	_bitsShift = 0;
+	_mask = 1;
+}
+
+void
+PaletteStorage::Clear()
+{
+	std::vector<unsigned char>().swap(_palette);
+	std::vector<Word>().swap(_words);
+	_numElements = 0;
+	_bitsShift = 0;
+	_mask = 1;
+}
+
+int
+PaletteStorage::FindType(unsigned char type) const
+{
+	/* Palette is tiny in most cases, linear search is the fastest one */
+	for (size_t i = 0; i < _palette.size(); ++i)
+		if (_palette[i] == type)
+			return (int)i;
+
+	return -1;
+}
+
+void
+PaletteStorage::Set(int index, unsigned char type)
+{
+	assert(index >= 0 && index < _numElements, "Index out of bound: %d/%d", index, _numElements - 1);
+
+	/* Writing the same type into uniform storage does not change anything */
+	if (IsUniform() && _palette[0] == type)
+		return;
+
+	int paletteIndex;
+	if (IsUniform()) {
+		/* Materialize indices, all existing voxels are pointing to the first type */
+		_palette.push_back(type);
+		paletteIndex = 1;
+		Repack(0);
+	}
+	else {
+		paletteIndex = FindType(type);
+		if (paletteIndex == -1) {
+			assert(_palette.size() < 256, "Palette is full, cannot add type %d", type);
+
+			paletteIndex = (int)_palette.size();
+			_palette.push_back(type);
+
+			/* If new index cannot be stored using current width, double it */
+			if ((Word)paletteIndex > _mask)
+				Repack(_bitsShift + 1);
+		}
+	}
+
+	int bit = index << _bitsShift;
+	Word& word = _words[bit >> _wordShift];
+	int shift = bit & _wordMask;
+	word = (word & ~(_mask << shift)) | ((Word)paletteIndex << shift);
+}
+
+void
+PaletteStorage::Unpack(Voxel* voxels) const
+{
+	if (IsUniform()) {
+		for (int i = 0; i < _numElements; ++i)
+			voxels[i].SetType(_palette[0]);
+		return;
+	}
+
+	const int perWord = 1 << (_wordShift - _bitsShift);
+	const int bits = 1 << _bitsShift;
+
+	/* Decode whole words at once instead of calling Get for each voxel */
+	int n = 0;
+	for (size_t w = 0; w < _words.size() && n < _numElements; ++w) {
+		Word word = _words[w];
+		for (int i = 0; i < perWord && n < _numElements; ++i, word >>= bits)
+			voxels[n++].SetType(_palette[word & _mask]);
+	}
+}
+
+uint64_t
+PaletteStorage::GetHash() const
+{
+	/* Types are gathered into 8 byte lanes, so only every eighth voxel costs a multiplication */
+	uint64_t hash = hashCombine(0, (uint64_t)_numElements);
+	uint64_t lane = 0;
+	int shift = 0;
+
+	if (IsUniform()) {
+		for (int i = 0; i < _numElements; ++i) {
+			lane |= (uint64_t)_palette[0] << shift;
+			shift += 8;
+			if (shift == 64) {
+				hash = hashCombine(hash, lane);
+				lane = 0;
+				shift = 0;
+			}
+		}
+	}
+	else {
+		const int perWord = 1 << (_wordShift - _bitsShift);
+		const int bits = 1 << _bitsShift;
+
+		int n = 0;
+		for (size_t w = 0; w < _words.size() && n < _numElements; ++w) {
+			Word word = _words[w];
+			for (int i = 0; i < perWord && n < _numElements; ++i, ++n, word >>= bits) {
+				lane |= (uint64_t)_palette[word & _mask] << shift;
+				shift += 8;
+				if (shift == 64) {
+					hash = hashCombine(hash, lane);
+					lane = 0;
+					shift = 0;
+				}
+			}
+		}
+	}
+
+	return shift > 0 ? hashCombine(hash, lane) : hash;
+}
+
+void
+PaletteStorage::Compact()
+{
+	if (_numElements == 0 || IsUniform())
+		return;
+
+	/* Count usage of each palette entry */
+	std::vector<int> used(_palette.size(), 0);
+	for (int i = 0; i < _numElements; ++i)
+		used[GetIndex(i)]++;
+
+	/* Build new palette only from used types */
+	std::vector<unsigned char> palette;
+	std::vector<int> remap(_palette.size(), 0);
+	for (size_t i = 0; i < _palette.size(); ++i) {
+		if (used[i] > 0) {
+			remap[i] = (int)palette.size();
+			palette.push_back(_palette[i]);
+		}
+	}
+
+	/* Only one type is used, there is no need to store indices */
+	if (palette.size() == 1) {
+		Fill(palette[0]);
+		return;
+	}
+
+	/* Find the smallest width that can hold all indices */
+	int bitsShift = 0;
+	while ((size_t)1 << (1 << bitsShift) < palette.size())
+		++bitsShift;
+
+	Repack(bitsShift, remap.data());
+	_palette.swap(palette);
+}
+
+void
+PaletteStorage::Repack(int bitsShift, const int* remap)
+{
+	assert(bitsShift <= 3, "Palette cannot use more than 8 bits per voxel");
+
+	std::vector<Word> words((((size_t)_numElements << bitsShift) + _wordMask) >> _wordShift, 0);
+	for (int i = 0; i < _numElements; ++i) {
+		Word paletteIndex = (Word)GetIndex(i);
+		if (remap != nullptr)
+			paletteIndex = (Word)remap[paletteIndex];
+
+		int bit = i << bitsShift;
+		words[bit >> _wordShift] |= paletteIndex << (bit & _wordMask);
+	}
+
+	_words.swap(words);
+	_bitsShift = bitsShift;
+	_mask = (Word)((1u << (1 << bitsShift)) - 1);
+}
+
+size_t
+PaletteStorage::GetMemoryUsage() const
+{
+	return _palette.capacity() * sizeof(unsigned char) + _words.capacity() * sizeof(Word);
+}
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Assert.h"
+#include "Voxel.h"
+
+#include <vector>
+#include <stdint.h>
+
+namespace vengine {
+
+/*
+* Compressed storage of the voxel types. Instead of keeping whole Voxel for each cell, it is keeping palette
+* of the types used inside the storage and bit-packed array of indices into this palette. Indices are using
+* 1, 2, 4 or 8 bits and the width grows automatically when new type is introduced.
+* If all voxels have the same type, storage is uniform and does not allocate indices at all.
+*/
+class PaletteStorage {
+public:
+	PaletteStorage();
+
+	/* Initialize storage for given number of voxels, all of them will have given type. Storage will be uniform. */
+	void Init(int numElements, unsigned char type = Voxel::NONE);
+	/* Set all voxels to given type and release indices */
+	void Fill(unsigned char type);
+	/* Release all memory used by the storage */
+	void Clear();
+
+	/* Get type of the voxel with given index */
+	unsigned char Get(int index) const;
+	/* Set type of the voxel with given index. If type is not in the palette yet, it will be added. */
+	void Set(int index, unsigned char type);
+
+	/* Check if all voxels have the same type and no indices are allocated */
+	bool IsUniform() const;
+	/* Get type of all voxels in uniform storage */
+	unsigned char GetUniformType() const;
+
+	/* Decode all types into given array. Array must be big enough to store all elements. */
+	void Unpack(Voxel* voxels) const;
+	/* Get hash of the types of all voxels. It does not depend on the palette, so storages with the same types have the same hash. */
+	uint64_t GetHash() const;
+
+	/* Remove unused types from the palette and pack indices using as few bits as possible. If only one type is used, storage will become uniform. */
+	void Compact();
+
+	/* Get number of the bits used for each voxel, 0 for uniform storage */
+	int GetBitsPerVoxel() const;
+	/* Get number of types stored in the palette */
+	int GetPaletteSize() const;
+	/* Get type stored at given index of the palette. Palette can contain types which are not used anymore. */
+	unsigned char GetPaletteType(int index) const;
+	/* Get number of bytes allocated for palette and indices */
+	size_t GetMemoryUsage() const;
+
+private:
+	typedef uint32_t Word;
+	static const int _wordShift = 5;	/* Log2 of bits in Word */
+	static const int _wordMask = 31;	/* Bits in Word - 1 */
+
+	std::vector<unsigned char> _palette; /* Types used inside storage, packed indices are pointing into this array */
+	std::vector<Word> _words;			 /* Bit-packed indices into the palette */
+	int _numElements;	/* Number of voxels in the storage */
+	int _bitsShift;		/* Log2 of bits used per each index, indices are never crossing word boundary. Not used when uniform. */
+	Word _mask;			/* Mask of the single index */
+
+	/* Get index of the type in the palette or -1 if not found */
+	int FindType(unsigned char type) const;
+	/* Get raw palette index stored for given voxel */
+	int GetIndex(int index) const;
+	/* Pack all indices again using new width, remapping palette indices if remap is not null */
+	void Repack(int bitsShift, const int* remap = nullptr);
+};
+
+
+inline bool
+PaletteStorage::IsUniform() const
+{
+	return _words.empty();
+}
+
+inline unsigned char
+PaletteStorage::GetUniformType() const
+{
+	assert(IsUniform(), "Storage is not uniform");
+	return _palette[0];
+}
+
+inline int
+PaletteStorage::GetIndex(int index) const
+{
+	if (IsUniform())
+		return 0;
+
+	int bit = index << _bitsShift;
+	return (int)((_words[bit >> _wordShift] >> (bit & _wordMask)) & _mask);
+}
+
+inline unsigned char
+PaletteStorage::Get(int index) const
+{
+	assert(index >= 0 && index < _numElements, "Index out of bound: %d/%d", index, _numElements - 1);
+	return _palette[GetIndex(index)];
+}
+
+inline int
+PaletteStorage::GetBitsPerVoxel() const
+{
+	return IsUniform() ? 0 : 1 << _bitsShift;
+}
+
+inline int
+PaletteStorage::GetPaletteSize() const
+{
+	return (int)_palette.size();
+}
+
+inline unsigned char
+PaletteStorage::GetPaletteType(int index) const
+{
+	assert(index >= 0 && index < (int)_palette.size(), "Palette index out of bound: %d/%d", index, (int)_palette.size() - 1);
+	return _palette[index];
+}
+
+}
@@ -1,4 +1,7 @@
 #include "VoxelArray3D.h"
+#include "OccupancyMask.h"
+
+#include <algorithm>
 
 namespace vengine {
 
@@ -31,11 +34,17 @@ VoxelArray3D::Init(const std::string& name, int sx, int sy, int sz)
 {
 	assert(!IsValid(), "Cannot initialize not empty voxel array.");
 
-	_numElements = sx*sy*sz;
-	_name = name;
+	InitDimension(name, sx, sy, sz);
 	if (_numElements > 0) {
 		_voxels = new Voxel[_numElements];
 	}
+}
+
+void
+VoxelArray3D::InitDimension(const std::string& name, int sx, int sy, int sz)
+{
+	_numElements = sx*sy*sz;
+	_name = name;
 	_dimension[0] = sx;
 	_dimension[1] = sy;
 	_dimension[2] = sz; 
@@ -76,7 +85,7 @@ VoxelArray3D::Clear()
 const Voxel& 
 VoxelArray3D::Get(int x, int y, int z) const
 {
-	int index = x + _sx*(y + _sy*z);
+	int index = GetIndex(x, y, z);
 	assert(index < _numElements, "Index out of bound: %d/%d", index, _numElements-1);
 
 	return _voxels[index];
@@ -109,12 +118,36 @@ VoxelArray3D::SetTypes(unsigned char *types)
 	_empty = false;
 }
 
+std::vector<const Voxel*>&
+VoxelArray3D::GetMaskScratch()
+{
+	static thread_local std::vector<const Voxel*> mask;
+	return mask;
+}
+
 void
 VoxelArray3D::GenerateMesh(VoxelMesh* mesh)
 {
 	assert(IsValid(), "Cannot generate mesh for empty Voxel Array.");
 
+	GenerateMesh(RuntimeDimension(_sx, _sy, _sz), NoBorder(), _voxels, mesh);
+}
+
+template <class Dimension, class Border>
+void
+VoxelArray3D::GenerateMesh(const Dimension& dim, const Border& border, const Voxel* voxels, VoxelMesh* mesh)
+{
+	assert(voxels != nullptr, "Cannot generate mesh from null voxels.");
+
 	mesh->ClearVertices();
+	mesh->SetTransform(_voxelSize, _center);
+
+	/* Mask is big enough for the largest plane, it is reused by all directions and kept for next calls on this thread */
+	std::vector<const Voxel*>& maskScratch = GetMaskScratch();
+	size_t maskSize = std::max(dim[0] * dim[1], std::max(dim[1] * dim[2], dim[2] * dim[0]));
+	if (maskScratch.size() < maskSize)
+		maskScratch.resize(maskSize);
+	const Voxel** mask = maskScratch.data();
 
 	int total_quads = 0;
 	bool front = false;
@@ -124,8 +157,7 @@ VoxelArray3D::GenerateMesh(VoxelMesh* mesh)
 			int u = (dir + 1) % 3;
 			int v = (dir + 2) % 3;
 
-			const Voxel** mask = new const Voxel*[_dimension[u] * _dimension[v]];
-			memset(mask, NULL, _dimension[u] * _dimension[v] * sizeof(Voxel *));
+			/* Mask does not need clearing, each layer is overwriting it completely before it is used */
 			int coords[3] = { 0, 0, 0 };
 			/* This arrays helps to determine next plane for face comparision */
 			int next[3] = { 0, 0, 0 };
@@ -150,16 +182,16 @@ VoxelArray3D::GenerateMesh(VoxelMesh* mesh)
 
 			/* For each layer */
 			coords[dir] = -1;
-			while (coords[dir] < _dimension[dir]) {
+			while (coords[dir] < dim[dir]) {
 
 				/* Creating mask */
 				int n = 0;
-				for (coords[v] = 0; coords[v] < _dimension[v]; coords[v]++) {
-					for (coords[u] = 0; coords[u] < _dimension[u]; coords[u]++) {
+				for (coords[v] = 0; coords[v] < dim[v]; coords[v]++) {
+					for (coords[u] = 0; coords[u] < dim[u]; coords[u]++) {
 						/* Get earlier and current layer, we must be careful to do not exceed voxel array size */
-						const Voxel* earlier = (coords[dir] >= 0) ? &Get(coords[0], coords[1], coords[2]): nullptr;
-						const Voxel* current = (coords[dir] < _dimension[dir] - 1) ?
-							&Get(coords[0] + next[0], coords[1] + next[1], coords[2] + next[2]) : nullptr;
+						const Voxel* earlier = (coords[dir] >= 0) ? &voxels[dim.Index(coords[0], coords[1], coords[2])] : nullptr;
+						const Voxel* current = (coords[dir] < dim[dir] - 1) ?
+							&voxels[dim.Index(coords[0] + next[0], coords[1] + next[1], coords[2] + next[2])] : nullptr;
 
 						/* If object is air, store it as nullptr */
 						if (earlier != nullptr && earlier->IsEmpty())
@@ -167,11 +199,18 @@ VoxelArray3D::GenerateMesh(VoxelMesh* mesh)
 						if (current != nullptr && current->IsEmpty())
 							current = nullptr;
 
+						/* Voxel which face is checked and information if it is lying on the edge of the array */
+						const Voxel* inside = front ? earlier : current;
+						bool edge = front ? coords[dir] == dim[dir] - 1 : coords[dir] < 0;
+
 						/* Merge blocks if it is possible */
 						if (current != nullptr && earlier != nullptr && !earlier->IsTransparent() && !current->IsTransparent())
 							mask[n++] = nullptr;
+						/* Face on the edge can be covered by opaque neighbour */
+						else if (edge && inside != nullptr && !inside->IsTransparent() && border.IsOpaque(dir, front, coords[u], coords[v]))
+							mask[n++] = nullptr;
 						else
-							mask[n++] = front ? earlier : current;
+							mask[n++] = inside;
 					}
 				}
 
@@ -180,13 +219,13 @@ VoxelArray3D::GenerateMesh(VoxelMesh* mesh)
 				/* Create layers from mask */
 				n = 0;
 				int w, h;
-				for (int i = 0; i < _dimension[v]; i++) {
-					for (int j = 0; j < _dimension[u]; ) {
+				for (int i = 0; i < dim[v]; i++) {
+					for (int j = 0; j < dim[u]; ) {
 
 						if (mask[n] != nullptr) {
 							total_quads += 1;
 							/* Width first, chosing different order can give different result, example: letter T, depending on order it can be meshed with 2 or 3 quads */
-							for (w = 1; j + w < _dimension[u]; ++w) {
+							for (w = 1; j + w < dim[u]; ++w) {
 								int index = n + w;
 								/* If faces are different, we cannot merge them */
 								if (mask[index] == nullptr || *mask[index] != *mask[n])
@@ -195,9 +234,9 @@ VoxelArray3D::GenerateMesh(VoxelMesh* mesh)
 
 							/* Height */
 							bool finish = false;
-							for (h = 1; i + h < _dimension[v]; h++) {
+							for (h = 1; i + h < dim[v]; h++) {
 								for (int k = 0; k < w; k++) {
-									int index = n + k + h * _dimension[u];
+									int index = n + k + h * dim[u];
 									if (mask[index] == nullptr || *mask[index] != *mask[n]) {
 										finish = true;
 										break;
@@ -216,20 +255,13 @@ VoxelArray3D::GenerateMesh(VoxelMesh* mesh)
 							du[u] = w;
 							dv[v] = h;
 
-							/* Create points for the quad */
-							Vector3 p0 = Vector3(float(coords[0]), float(coords[1]), float(coords[2])),
-								p1 = Vector3(float(coords[0] + du[0]), float(coords[1] + du[1]), float(coords[2] + du[2])),
-								p2 = Vector3(float(coords[0] + du[0] + dv[0]), float(coords[1] + du[1] + dv[1]), float(coords[2] + du[2] + dv[2])),
-								p3 = Vector3(float(coords[0] + dv[0]), float(coords[1] + dv[1]), float(coords[2] + dv[2]));
-
 							/* Push quad into the mesh */
-							InsertQuad(mesh, *mask[n], face, front, w, h,
-									   p0, p1, p2, p3);
+							InsertQuad(mesh, *mask[n], face, front, w, h, coords, du, dv);
 
 							/* Removing used elements */
 							for (int l = 0; l < h; ++l) {
 								for (int k = 0; k < w; ++k) {
-									mask[n + k + l * _dimension[u]] = NULL;
+									mask[n + k + l * dim[u]] = NULL;
 								}
 							}
 							/* Advance */
@@ -243,8 +275,116 @@ VoxelArray3D::GenerateMesh(VoxelMesh* mesh)
 					}
 				}
 			}
+		}
+	}
 
-			delete[] mask;
+	/* If did not added any quads, indicate that this voxel array is empty */
+	if (total_quads == 0)
+		_empty = true;
+}
+
+/* Transpose N x N bit matrix in place, so bit x of row y becomes bit y of row x. Blocks off the diagonal are swapped recursively. */
+template <int N>
+static void transposeRows(typename OccupancyRow<N>::Type rows[])
+{
+	typedef typename OccupancyRow<N>::Type Row;
+	Row mask = OccupancyMask<N>::RangeMask(0, N / 2 - 1);
+	for (int j = N / 2; j != 0; j >>= 1, mask ^= (Row)(mask << j)) {
+		for (int k = 0; k < N; k = ((k | j) + 1) & ~j) {
+			Row swapped = (Row)(((rows[k] >> j) ^ rows[k | j]) & mask);
+			rows[k] ^= (Row)(swapped << j);
+			rows[k | j] ^= swapped;
+		}
+	}
+}
+
+/*
+* Fill bit planes of all three axes from rows along X indexed with y + N * z. Row with bits along axis a is stored
+* at index b + N * c of plane a, where b and c are next axes. Planes of Y and Z are transposed slices of the rows.
+*/
+template <int N>
+static void fillPlanes(const typename OccupancyRow<N>::Type* rows, typename OccupancyRow<N>::Type* planes)
+{
+	typedef typename OccupancyRow<N>::Type Row;
+	const int planeSize = N * N;
+	Row slice[N];
+
+	std::copy(rows, rows + planeSize, planes);
+
+	for (int z = 0; z < N; ++z) {
+		for (int y = 0; y < N; ++y)
+			slice[y] = rows[y + N * z];
+		transposeRows<N>(slice);
+		for (int x = 0; x < N; ++x)
+			planes[planeSize + z + N * x] = slice[x];
+	}
+
+	for (int y = 0; y < N; ++y) {
+		for (int z = 0; z < N; ++z)
+			slice[z] = rows[y + N * z];
+		transposeRows<N>(slice);
+		std::copy(slice, slice + N, planes + 2 * planeSize + N * y);
+	}
+}
+
+template <int N>
+void
+VoxelArray3D::GenerateBinaryMesh(const ChunkBorder<N>& border, const Voxel* voxels, const typename OccupancyRow<N>::Type* solidRows,
+								 const typename OccupancyRow<N>::Type* opaqueRows, VoxelMesh* mesh)
+{
+	assert(voxels != nullptr, "Cannot generate mesh from null voxels.");
+	typedef typename OccupancyRow<N>::Type Row;
+	const int planeSize = N * N;
+
+	mesh->ClearVertices();
+	mesh->SetTransform(_voxelSize, _center);
+
+	/* Solid and opaque bit planes, one for each axis. Rows along u axis of each direction are indexed with v + N * dir. */
+	static thread_local std::vector<Row> planes;
+	planes.resize(6 * planeSize);
+	Row* solid = planes.data();
+	Row* opaque = solid;
+
+	fillPlanes<N>(solidRows, solid);
+	/* Without transparent voxels both planes are the same */
+	if (opaqueRows != solidRows) {
+		opaque = solid + 3 * planeSize;
+		fillPlanes<N>(opaqueRows, opaque);
+	}
+
+	/* Quads are grouped into slices, so single slices can be replaced later with UpdateBinarySlice */
+	mesh->BeginSlices(6 * N);
+
+	Row faces[N];
+	int total_quads = 0;
+	bool front = false;
+	for (int i = 0; i < 2; ++i, front = !front) {
+		for (int dir = 0; dir < 3; dir++) {
+			int u = (dir + 1) % 3;
+			const Row* solidU = solid + u * planeSize;
+			const Row* opaqueU = opaque + u * planeSize;
+
+			/* For each layer of the voxels, faces are lying between voxels 'layer' and 'layer + 1' */
+			for (int voxelLayer = 0; voxelLayer < N; ++voxelLayer) {
+				int layer = front ? voxelLayer : voxelLayer - 1;
+
+				/* Face is visible if voxel is solid and it is not covered by opaque voxel, when both of them are opaque. Outside the chunk border is used. */
+				Row anyFace = 0;
+				for (int row = 0; row < N; ++row) {
+					Row earlier = layer >= 0 ? solidU[row + N * layer] : (Row)0;
+					Row current = layer < N - 1 ? solidU[row + N * (layer + 1)] : (Row)0;
+					Row earlierOpaque = layer >= 0 ? opaqueU[row + N * layer] : border.GetRow(dir, false, row);
+					Row currentOpaque = layer < N - 1 ? opaqueU[row + N * (layer + 1)] : border.GetRow(dir, true, row);
+					Row hidden = (Row)(earlierOpaque & currentOpaque);
+
+					faces[row] = (Row)((front ? earlier : current) & ~hidden);
+					anyFace |= faces[row];
+				}
+
+				if (anyFace != 0)
+					total_quads += MeshBinaryFaces<N>(faces, voxels, dir, front, voxelLayer, mesh);
+				mesh->EndSlice(GetSlice<N>(dir, front, voxelLayer));
+			}
 		}
 	}
 
@@ -253,6 +393,195 @@ VoxelArray3D::GenerateMesh(VoxelMesh* mesh)
 		_empty = true;
 }
 
+template <int N>
+void
+VoxelArray3D::UpdateBinarySlice(const ChunkBorder<N>& border, const Voxel* voxels, int dir, bool front, int voxelLayer, VoxelMesh* mesh)
+{
+	assert(voxels != nullptr, "Cannot generate mesh from null voxels.");
+	assert(mesh->HasSlices(6 * N), "Mesh must be generated with GenerateBinaryMesh first.");
+	typedef typename OccupancyRow<N>::Type Row;
+	const FixedDimension<N> dim;
+
+	int u = (dir + 1) % 3;
+	int v = (dir + 2) % 3;
+	/* Voxels covering the faces, outside the chunk border is used */
+	int neighbour = front ? voxelLayer + 1 : voxelLayer - 1;
+	bool inside = neighbour >= 0 && neighbour < N;
+
+	Row faces[N];
+	Row anyFace = 0;
+	int coords[3];
+	int neighbourCoords[3];
+	for (int row = 0; row < N; ++row) {
+		Row covered = inside ? (Row)0 : border.GetRow(dir, front, row);
+		faces[row] = 0;
+
+		coords[dir] = voxelLayer;
+		coords[v] = row;
+		neighbourCoords[dir] = neighbour;
+		neighbourCoords[v] = row;
+		for (int j = 0; j < N; ++j) {
+			coords[u] = j;
+			const Voxel& voxel = voxels[dim.Index(coords[0], coords[1], coords[2])];
+			if (voxel.IsEmpty())
+				continue;
+
+			bool hidden;
+			if (voxel.IsTransparent()) {
+				hidden = false;
+			}
+			else if (inside) {
+				neighbourCoords[u] = j;
+				const Voxel& other = voxels[dim.Index(neighbourCoords[0], neighbourCoords[1], neighbourCoords[2])];
+				hidden = !other.IsEmpty() && !other.IsTransparent();
+			}
+			else {
+				hidden = (covered >> j) & 1;
+			}
+
+			if (!hidden)
+				faces[row] |= (Row)((Row)1 << j);
+		}
+		anyFace |= faces[row];
+	}
+
+	/* Quads are generated into separate mesh and then copied over the old quads of the slice */
+	static thread_local VoxelMesh slice;
+	slice.ClearVertices();
+	if (anyFace != 0)
+		MeshBinaryFaces<N>(faces, voxels, dir, front, voxelLayer, &slice);
+
+	const VoxelVertices& vertices = slice.GetVertices();
+	mesh->ReplaceSlice(GetSlice<N>(dir, front, voxelLayer), vertices.data(), slice.GetQuadsNumber());
+}
+
+template <int N>
+int
+VoxelArray3D::MeshBinaryFaces(typename OccupancyRow<N>::Type faces[], const Voxel* voxels, int dir, bool front, int voxelLayer, VoxelMesh* mesh)
+{
+	typedef typename OccupancyRow<N>::Type Row;
+	const FixedDimension<N> dim;
+	int u = (dir + 1) % 3;
+	int v = (dir + 2) % 3;
+	Voxel::Side face = GetSide(dir, front);
+	int quads = 0;
+
+	/* Layer of the voxels which types are used for the faces */
+	int coords[3];
+	coords[dir] = voxelLayer;
+
+	for (int row = 0; row < N; ++row) {
+		coords[v] = row;
+		while (faces[row] != 0) {
+			int j = bitScanForward(faces[row]);
+			coords[u] = j;
+			unsigned char type = voxels[dim.Index(coords[0], coords[1], coords[2])].GetType();
+
+			/* Width first, limited by the run of the visible faces and then by the type */
+			Row run = (Row)~(Row)(faces[row] >> j);
+			int ones = run == 0 ? N - j : bitScanForward(run);
+			int w;
+			for (w = 1; w < ones; ++w) {
+				coords[u] = j + w;
+				if (voxels[dim.Index(coords[0], coords[1], coords[2])].GetType() != type)
+					break;
+			}
+
+			/* Height, whole width of the row is checked with single mask */
+			Row quad = OccupancyMask<N>::RangeMask(j, j + w - 1);
+			int h;
+			for (h = 1; row + h < N; ++h) {
+				if ((faces[row + h] & quad) != quad)
+					break;
+
+				coords[v] = row + h;
+				int k;
+				for (k = 0; k < w; ++k) {
+					coords[u] = j + k;
+					if (voxels[dim.Index(coords[0], coords[1], coords[2])].GetType() != type)
+						break;
+				}
+				if (k < w)
+					break;
+			}
+
+			/* Removing used faces */
+			for (int l = 0; l < h; ++l)
+				faces[row + l] &= (Row)~quad;
+
+			/* Quads of the front faces are lying on the far side of the voxel */
+			int quadCoords[3];
+			quadCoords[dir] = front ? voxelLayer + 1 : voxelLayer;
+			quadCoords[u] = j;
+			quadCoords[v] = row;
+
+			int du[3] = { 0, 0, 0 };
+			int dv[3] = { 0, 0, 0 };
+			du[u] = w;
+			dv[v] = h;
+
+			InsertQuad(mesh, Voxel(type), face, front, w, h, quadCoords, du, dv);
+			quads += 1;
+			coords[v] = row;
+		}
+	}
+
+	return quads;
+}
+
+Voxel::Side
+VoxelArray3D::GetSide(int dir, bool front)
+{
+	switch (dir) {
+	/* Axis X */
+	case 0:
+		return front ? Voxel::EAST : Voxel::WEST;
+	/* Axis Y */
+	case 1:
+		return front ? Voxel::TOP : Voxel::BOTTOM;
+	/* Axis Z */
+	default:
+		return front ? Voxel::NORTH : Voxel::SOUTH;
+	}
+}
+
+void
+VoxelArray3D::GenerateShell(const Voxel& voxel, VoxelMesh* mesh, uint8_t hidden)
+{
+	assert(!voxel.IsEmpty() && !voxel.IsTransparent(), "Shell can be generated only for opaque voxels.");
+
+	mesh->ClearVertices();
+	mesh->SetTransform(_voxelSize, _center);
+	mesh->ReserveQuads(6);
+
+	/* Quads are created in the same order as greedy meshing would create them for filled array */
+	bool front = false;
+	for (int i = 0; i < 2; ++i, front = !front) {
+		for (int dir = 0; dir < 3; dir++) {
+			/* Face is covered by the neighbour */
+			if (hidden & (1 << (dir + 3 * front)))
+				continue;
+
+			int u = (dir + 1) % 3;
+			int v = (dir + 2) % 3;
+			Voxel::Side face = GetSide(dir, front);
+
+			/* Back faces are lying on the first layer, front faces behind the last one */
+			int coords[3] = { 0, 0, 0 };
+			coords[dir] = front ? _dimension[dir] : 0;
+
+			int du[3] = { 0, 0, 0 };
+			int dv[3] = { 0, 0, 0 };
+			du[u] = _dimension[u];
+			dv[v] = _dimension[v];
+
+			InsertQuad(mesh, voxel, face, front, _dimension[u], _dimension[v], coords, du, dv);
+		}
+	}
+
+	_empty = hidden == 0x3f;
+}
+
 bool
 VoxelArray3D::IsValid() const
 {
@@ -261,83 +590,50 @@ VoxelArray3D::IsValid() const
 
 void
 VoxelArray3D::InsertQuad(VoxelMesh* mesh, const Voxel& voxel, Voxel::Side side, bool front, int w, int h,
-				const Vector3& p0, const Vector3& p1, const Vector3& p2, const Vector3& p3)
+				const int p[3], const int du[3], const int dv[3])
 {
-	Vertices vertices(4);
-	Indices indices(6);
-	int indicesOffset = mesh->GetVertices().size();
-
-	/* Order used for culling faces */
-	if (front) {
-		indices[0] = indicesOffset + 2; indices[1] = indicesOffset + 3, indices[2] = indicesOffset;
-		indices[3] = indicesOffset; indices[4] = indicesOffset + 1, indices[5] = indicesOffset + 2;
-	}
-	else {
-		indices[0] = indicesOffset; indices[1] = indicesOffset + 3, indices[2] = indicesOffset + 2;
-		indices[3] = indicesOffset + 2; indices[4] = indicesOffset + 1, indices[5] = indicesOffset;
-	}
-
-	/* Calculate position. Model should be in center of the voxel array and add info about voxel size */
-	vertices[0].position = p0 * _voxelSize - _center;
-	vertices[1].position = p1 * _voxelSize - _center;
-	vertices[2].position = p2 * _voxelSize - _center;
-	vertices[3].position = p3 * _voxelSize - _center;
-
-	/* Set normals depending on the side */
-	switch (side) {
-	case Voxel::NORTH:
-		for(int i = 0; i < 4; ++i)
-			vertices[i].normal = Vector3::forward;
-		break;
-	case Voxel::SOUTH:
-		for (int i = 0; i < 4; ++i)
-			vertices[i].normal = Vector3::backward;
-		break;
-	case Voxel::EAST:
-		for (int i = 0; i < 4; ++i)
-			vertices[i].normal = Vector3::right;
-		break;
-	case Voxel::WEST:
-		for (int i = 0; i < 4; ++i)
-			vertices[i].normal = Vector3::left;
-		break;
-	case Voxel::TOP:
-		for (int i = 0; i < 4; ++i)
-			vertices[i].normal = Vector3::up;
-		break;
-	case Voxel::BOTTOM:
-		for (int i = 0; i < 4; ++i)
-			vertices[i].normal = Vector3::down;
-		break;
-	}
-	unsigned char type = voxel.GetType();
+	/* Quad is prepared on the stack and copied straight into the mesh storage */
+	VoxelVertex vertices[4];
 
 	int u, v;
 	/* Get texture location in the atlas for the given type */
 	voxel.GetAtlasLocation(side, &u, &v);
 
+	/* Texture coordinates are telling how many times the tile is repeated. For EAST and WEST u v must be setted in different way or they will be flipped */
+	bool yAxe = side == Voxel::EAST || side == Voxel::WEST;
+	int texU[4] = { 0, yAxe ? 0 : w, yAxe ? h : w, yAxe ? h : 0 };
+	int texV[4] = { 0, yAxe ? w : 0, yAxe ? w : h, yAxe ? 0 : h };
 
+	/* Corners of the quad: p, p + du, p + du + dv, p + dv. Voxel size and center are applied in the shader. */
+	int du0[4] = { 0, 1, 1, 0 };
+	int dv0[4] = { 0, 0, 1, 1 };
 	for (int i = 0; i < 4; ++i) {
-		vertices[i].atlasOffset[0] = u;
-		vertices[i].atlasOffset[1] = v;
+		/* All quads are drawn with the same indices, so order of corners of back faces is reversed to keep them facing outside */
+		int c = front ? i : (4 - i) % 4;
+		vertices[i] = VoxelVertex::Pack(p[0] + du0[c] * du[0] + dv0[c] * dv[0],
+										p[1] + du0[c] * du[1] + dv0[c] * dv[1],
+										p[2] + du0[c] * du[2] + dv0[c] * dv[2],
+										side, texU[c], texV[c], u, v);
 	}
 
-	/* For EAST and WEST u v must be setted in different way or they will be flipped */
-	bool yAxe = side == Voxel::EAST || side == Voxel::WEST;
-
-	vertices[0].texUV.Set(0.0f, 0.0f);
-
-	if (yAxe) {
-		vertices[1].texUV.Set(0.0f, float(w));
-		vertices[2].texUV.Set(float(h), float(w));
-		vertices[3].texUV.Set(float(h), 0.0f);
-	}
-	else {
-		vertices[1].texUV.Set(float(w), 0.0f);
-		vertices[2].texUV.Set(float(w), float(h));
-		vertices[3].texUV.Set(0, float(h));
-	}
-	mesh->AddVertices(vertices, indices);
+	mesh->AddQuads(vertices, 1);
 }
 
+/* Mesher is used for arrays with any size and for chunks, which dimension is known at compile time */
+template void VoxelArray3D::GenerateMesh(const RuntimeDimension& dim, const NoBorder& border, const Voxel* voxels, VoxelMesh* mesh);
+template void VoxelArray3D::GenerateMesh(const FixedDimension<16>& dim, const ChunkBorder<16>& border, const Voxel* voxels, VoxelMesh* mesh);
+template void VoxelArray3D::GenerateMesh(const FixedDimension<32>& dim, const ChunkBorder<32>& border, const Voxel* voxels, VoxelMesh* mesh);
+template void VoxelArray3D::GenerateMesh(const FixedDimension<64>& dim, const ChunkBorder<64>& border, const Voxel* voxels, VoxelMesh* mesh);
+
+/* Binary mesher needs rows of bits, so it is available only for chunks */
+template void VoxelArray3D::GenerateBinaryMesh<16>(const ChunkBorder<16>& border, const Voxel* voxels, const OccupancyRow<16>::Type* solidRows,
+													   const OccupancyRow<16>::Type* opaqueRows, VoxelMesh* mesh);
+template void VoxelArray3D::GenerateBinaryMesh<32>(const ChunkBorder<32>& border, const Voxel* voxels, const OccupancyRow<32>::Type* solidRows,
+													   const OccupancyRow<32>::Type* opaqueRows, VoxelMesh* mesh);
+template void VoxelArray3D::GenerateBinaryMesh<64>(const ChunkBorder<64>& border, const Voxel* voxels, const OccupancyRow<64>::Type* solidRows,
+													   const OccupancyRow<64>::Type* opaqueRows, VoxelMesh* mesh);
+template void VoxelArray3D::UpdateBinarySlice<16>(const ChunkBorder<16>& border, const Voxel* voxels, int dir, bool front, int voxelLayer, VoxelMesh* mesh);
+template void VoxelArray3D::UpdateBinarySlice<32>(const ChunkBorder<32>& border, const Voxel* voxels, int dir, bool front, int voxelLayer, VoxelMesh* mesh);
+template void VoxelArray3D::UpdateBinarySlice<64>(const ChunkBorder<64>& border, const Voxel* voxels, int dir, bool front, int voxelLayer, VoxelMesh* mesh);
+
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 #include "Math/Vector3.h"
 #include "Voxel.h"
+#include "VoxelDimension.h"
+#include "VoxelBorder.h"
 #include "Resources/Renderables/VoxelMesh.h"
 
 namespace vengine {
@@ -66,9 +68,54 @@ protected:
 
 	Vector3 _center; /* Center of the voxel array */
 
-	/* Insert quad with given properties into the mesh */
+	/* Set name and dimension of the array without allocating voxels. Used by arrays that are storing voxels in different way. */
+	void InitDimension(const std::string& name, int sx, int sy, int sz);
+
+	/*
+	* Generate mesh from given voxels, which must have the same dimension as the array. Dimension can be
+	* RuntimeDimension or FixedDimension, the second one lets compiler turn indexing into shifts.
+	* Faces on the edges of the array are skipped if border says that they are covered by opaque neighbour.
+	*/
+	template <class Dimension, class Border>
+	void GenerateMesh(const Dimension& dim, const Border& border, const Voxel* voxels, VoxelMesh* mesh);
+	/*
+	* Generate mesh from given voxels of the cube with edge N, giving exactly the same quads as GenerateMesh.
+	* Visible faces of each layer are computed for whole rows using bit planes and merged using bit scans.
+	* Planes are built from solid and opaque rows along X indexed with y + N * z, the same as rows of the occupancy mask.
+	* Opaque rows can be the same pointer as solid ones when there are no transparent voxels. Voxels are read only for types of the quads.
+	*/
+	template <int N>
+	void GenerateBinaryMesh(const ChunkBorder<N>& border, const Voxel* voxels, const typename OccupancyRow<N>::Type* solidRows,
+							const typename OccupancyRow<N>::Type* opaqueRows, VoxelMesh* mesh);
+	/*
+	* Generate again quads of one slice of the mesh made by GenerateBinaryMesh - faces of given side lying on voxels of one layer.
+	* Quads are merged only inside the slice, so replacing it gives the same mesh as generating whole mesh again.
+	*/
+	template <int N>
+	void UpdateBinarySlice(const ChunkBorder<N>& border, const Voxel* voxels, int dir, bool front, int voxelLayer, VoxelMesh* mesh);
+	/* Get index of the slice with faces of given side lying on given layer of voxels */
+	template <int N>
+	static int GetSlice(int dir, bool front, int voxelLayer);
+	/*
+	* Generate mesh for the array completely filled with given opaque voxel - only six outer faces.
+	* Faces can be skipped using hidden bitfield, bit (dir + 3 * front) is hiding given face.
+	*/
+	void GenerateShell(const Voxel& voxel, VoxelMesh* mesh, uint8_t hidden = 0);
+	/* Get mask used by the mesher. It is separate for each thread and is never shrinking, so meshing is not allocating memory after first call. */
+	static std::vector<const Voxel*>& GetMaskScratch();
+
+	/* Get side of the voxel faced by quads created in given direction */
+	static Voxel::Side GetSide(int dir, bool front);
+
+	/* Get index in 1D array for given coordinates */
+	int GetIndex(int x, int y, int z) const;
+
+	/* Insert quad with corner p and edges du and dv given in voxel grid coordinates into the mesh */
 	void InsertQuad(VoxelMesh* mesh, const Voxel& voxel, Voxel::Side side, bool front, int w, int h,
-					const Vector3& p1, const Vector3& p2, const Vector3& p3, const Vector3& p4);
+					const int p[3], const int du[3], const int dv[3]);
+	/* Merge visible faces of one slice into quads, rows are cleared. Returns number of added quads. */
+	template <int N>
+	int MeshBinaryFaces(typename OccupancyRow<N>::Type faces[], const Voxel* voxels, int dir, bool front, int voxelLayer, VoxelMesh* mesh);
 };
 
 
@@ -81,6 +128,12 @@ VoxelArray3D::GetDimension(int *x, int *y, int *z) const
 	*z = _sz;
 }
 
+inline int
+VoxelArray3D::GetIndex(int x, int y, int z) const
+{
+	return x + _sx*(y + _sy*z);
+}
+
 inline void 
 VoxelArray3D::SetVoxelSize(float size)
 {
@@ -88,6 +141,14 @@ VoxelArray3D::SetVoxelSize(float size)
 	_center = Vector3((float)_sx, (float)_sy, (float)_sz) / 2.0f * _voxelSize;
 }
 
+template <int N>
+inline int
+VoxelArray3D::GetSlice(int dir, bool front, int voxelLayer)
+{
+	/* Slices are numbered in the order in which GenerateBinaryMesh is adding them */
+	return (dir + 3 * (int)front) * N + voxelLayer;
+}
+
 inline float 
 VoxelArray3D::GetVoxelSize() const
 {
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "OccupancyMask.h"
+#include "Math/MathFunctions.h"
+
+#include <cstring>
+
+namespace vengine {
+
+/* Border used by voxel arrays that do not have neighbours - nothing outside the array is covering its faces */
+struct NoBorder {
+	bool IsOpaque(int, bool, int, int) const
+	{
+		return false;
+	}
+};
+
+/*
+* Opaque voxels of the neighbouring chunks, lying just outside each of the six faces of the chunk with edge N.
+* Layers are stored for each direction used by the mesher: front layer lies after the last voxel, back one before the first.
+* Each layer is stored as N rows with bits along u axis of the direction (u = (dir + 1) % 3, v = (dir + 2) % 3).
+*/
+template <int N>
+struct ChunkBorder {
+	typedef typename OccupancyRow<N>::Type Row;
+
+	Row layers[3][2][N];	/* Rows of the layers indexed with direction, front and v */
+
+	ChunkBorder()
+	{
+		Clear();
+	}
+
+	/* Mark all neighbours as not existing */
+	void Clear()
+	{
+		memset(layers, 0, sizeof(layers));
+	}
+
+	/* Get row of the layer, bit u is set if voxel is opaque */
+	Row GetRow(int dir, bool front, int v) const
+	{
+		return layers[dir][front][v];
+	}
+
+	bool IsOpaque(int dir, bool front, int u, int v) const
+	{
+		return ((layers[dir][front][v] >> u) & 1) != 0;
+	}
+
+	/* Get hash of all layers */
+	uint64_t GetHash() const
+	{
+		const Row* rows = &layers[0][0][0];
+		uint64_t hash = 0;
+		for (int i = 0; i < 6 * N; ++i)
+			hash = hashCombine(hash, (uint64_t)rows[i]);
+		return hash;
+	}
+};
+
+}
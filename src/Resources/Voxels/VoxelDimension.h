@@ -0,0 +1,63 @@
+#pragma once
+
+namespace vengine {
+
+/* Compile time logarithm of the power of two */
+template <int N>
+struct Log2 {
+	static const int value = 1 + Log2<N / 2>::value;
+};
+
+template <>
+struct Log2<1> {
+	static const int value = 0;
+};
+
+/*
+* Dimensions of the voxel grid known only at the runtime. Used by the mesher for arrays
+* with any size, like models loaded by VoxelArrayManager.
+*/
+struct RuntimeDimension {
+	int size[3];
+
+	RuntimeDimension(int sx, int sy, int sz)
+	{
+		size[0] = sx;
+		size[1] = sy;
+		size[2] = sz;
+	}
+
+	int operator[](int axis) const
+	{
+		return size[axis];
+	}
+
+	int Index(int x, int y, int z) const
+	{
+		return x + size[0] * (y + size[1] * z);
+	}
+};
+
+/*
+* Dimensions of the cubic voxel grid known at the compile time. Edge must be power of two,
+* so indexing, offsets and sizes are compiled down to constants and shifts.
+*/
+template <int N>
+struct FixedDimension {
+	static_assert(N > 0 && (N & (N - 1)) == 0, "Fixed dimension must be power of two");
+
+	static const int edge = N;
+	static const int shift = Log2<N>::value;
+
+	int operator[](int) const
+	{
+		return N;
+	}
+
+	int Index(int x, int y, int z) const
+	{
+		return x | (y << shift) | (z << (2 * shift));
+	}
+};
+
+}
@@ -1,11 +1,46 @@
 #include "Engine/VEngine.h"
+#include "Benchmarks/ChunkMapBenchmark.h"
+#include "Benchmarks/MeshingBenchmark.h"
+#include "Benchmarks/NoiseBenchmark.h"
+#include "Benchmarks/TerrainBenchmark.h"
+#include "Benchmarks/WorldBenchmark.h"
+
+#include <cstring>
 
 using namespace vengine;
 
 VEngine engine;
 
-int main()
+int main(int argc, char* argv[])
 {
+	/*
+	* Benchmarks are not using window, so they are run before engine is initialized.
+	* Usage: --benchmark [chunkmap|meshing|noise|terrain|world] [--csv], meshing benchmark is run by default.
+	* With --csv, results are written to stdout as CSV rows with header, so they can be compared between runs,
+	* and all other messages go to stderr. Exit code is 0 if all checks of the benchmark passed, VE_FAULT otherwise.
+	* Heap allocations per mesh are counted only in the Benchmark configuration, which defines VE_COUNT_ALLOCATIONS.
+	*/
+	if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+		bool csv = false;
+		const char* name = "meshing";
+		for (int i = 2; i < argc; ++i) {
+			if (strcmp(argv[i], "--csv") == 0)
+				csv = true;
+			else
+				name = argv[i];
+		}
+
+		if (strcmp(name, "chunkmap") == 0)
+			return runChunkMapBenchmark(csv);
+		if (strcmp(name, "noise") == 0)
+			return runNoiseBenchmark(csv);
+		if (strcmp(name, "terrain") == 0)
+			return runTerrainBenchmark(csv);
+		if (strcmp(name, "world") == 0)
+			return runWorldBenchmark(csv);
+		return runMeshingBenchmark(csv);
+	}
+
 	if (engine.Init("VEngine")) {
 		std::cout << "\nInit failed!\n";
 		return VE_FAULT;